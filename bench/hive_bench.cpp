@@ -0,0 +1,396 @@
+// End-to-end benchmark driver.
+//
+//   hive_bench [--baseline FILE] [--write FILE] [scenario ...]
+//
+// Runs each scenario (a regular config file, headless and with a fixed seed)
+// in its own child process so peak RSS is per scenario, then compares ticks
+// per second and peak RSS against the baseline's tolerance bands. Without
+// scenario names the baseline's default set is run. Exits 1 on a regression
+// or a failed run. --write stores the measured numbers in baseline format.
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Simulation.h"
+
+namespace {
+
+// Just enough JSON for the baseline file: objects, arrays, strings,
+// numbers and booleans.
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<Json> array;
+    std::map<std::string, Json> object;
+
+    const Json *get(const std::string &key) const
+    {
+        auto it = object.find(key);
+        return it == object.end() ? nullptr : &it->second;
+    }
+    double num(const std::string &key, double fallback) const
+    {
+        const Json *v = get(key);
+        return v && v->type == Type::Number ? v->number : fallback;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string &text) : s(text) {}
+
+    Json parse()
+    {
+        Json v = value();
+        skip();
+        if (pos != s.size())
+            fail("trailing characters");
+        return v;
+    }
+
+private:
+    const std::string &s;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string &what)
+    {
+        throw std::runtime_error("baseline JSON: " + what + " at offset " + std::to_string(pos));
+    }
+    void skip()
+    {
+        while (pos < s.size() && std::isspace((unsigned char)s[pos]))
+            ++pos;
+    }
+    void expect(char c)
+    {
+        skip();
+        if (pos >= s.size() || s[pos] != c)
+            fail(std::string("expected '") + c + "'");
+        ++pos;
+    }
+    std::string str()
+    {
+        expect('"');
+        std::string out;
+        while (pos < s.size() && s[pos] != '"')
+        {
+            if (s[pos] == '\\' && pos + 1 < s.size())
+                ++pos;
+            out += s[pos++];
+        }
+        expect('"');
+        return out;
+    }
+    Json value()
+    {
+        skip();
+        if (pos >= s.size())
+            fail("unexpected end");
+        Json v;
+        char c = s[pos];
+        if (c == '{')
+        {
+            v.type = Json::Type::Object;
+            ++pos;
+            skip();
+            if (s[pos] == '}')
+            {
+                ++pos;
+                return v;
+            }
+            do
+            {
+                std::string key = str();
+                expect(':');
+                v.object[key] = value();
+                skip();
+            } while (pos < s.size() && s[pos] == ',' && ++pos);
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            v.type = Json::Type::Array;
+            ++pos;
+            skip();
+            if (s[pos] == ']')
+            {
+                ++pos;
+                return v;
+            }
+            do
+            {
+                v.array.push_back(value());
+                skip();
+            } while (pos < s.size() && s[pos] == ',' && ++pos);
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            v.type = Json::Type::String;
+            v.string = str();
+        }
+        else if (s.compare(pos, 4, "true") == 0 || s.compare(pos, 5, "false") == 0)
+        {
+            v.type = Json::Type::Bool;
+            v.boolean = s[pos] == 't';
+            pos += v.boolean ? 4 : 5;
+        }
+        else if (s.compare(pos, 4, "null") == 0)
+            pos += 4;
+        else
+        {
+            char *end = nullptr;
+            v.type = Json::Type::Number;
+            v.number = std::strtod(s.c_str() + pos, &end);
+            if (end == s.c_str() + pos)
+                fail("bad value");
+            pos = end - s.c_str();
+        }
+        return v;
+    }
+};
+
+struct Scenario {
+    std::string name;
+    std::string config;
+    bool isDefault = false;
+    double ticksPerSec = 0; // 0 = no baseline recorded
+    double peakRssMb = 0;
+    double ticksTolerance = 0;
+    double rssTolerance = 0;
+};
+
+struct Result {
+    bool ok = false;
+    long long ticks = 0;
+    long long delivered = 0;
+    long long wallUs = 0; // the tick loop, setup excluded
+    long long rssKb = 0;
+    PhaseTimes phases;
+};
+
+// Runs one scenario in a child process and reads its numbers from a pipe.
+Result runScenario(const Scenario &sc)
+{
+    Result res;
+    char *cfgPath = realpath(sc.config.c_str(), nullptr);
+    if (!cfgPath)
+    {
+        std::cerr << sc.name << ": cannot find " << sc.config << "\n";
+        return res;
+    }
+    std::string config(cfgPath);
+    std::free(cfgPath);
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        return res;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        // keep the simulator's progress output and report out of the way
+        char dir[] = "/tmp/hive_bench_XXXXXX";
+        int devnull = open("/dev/null", O_WRONLY);
+        if (!mkdtemp(dir) || chdir(dir) != 0 || devnull < 0)
+            _exit(2);
+        dup2(devnull, STDOUT_FILENO);
+
+        auto start = std::chrono::steady_clock::now();
+        long long ticks = 0, delivered = 0;
+        PhaseTimes phases;
+        {
+            Simulation sim(config);
+            sim.run();
+            ticks = sim.getCurrentTick();
+            delivered = sim.getLedger().delivered;
+            phases = sim.getPhaseTimes();
+        }
+        long long total =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+
+        std::ostringstream out;
+        out << ticks << ' ' << delivered << ' ' << (total - phases.setup) << ' ' << ru.ru_maxrss << ' '
+            << phases.setup << ' ' << phases.spawn << ' ' << phases.dispatch << ' ' << phases.movement << ' '
+            << phases.telemetry << ' ' << phases.render << '\n';
+        std::string line = out.str();
+        ssize_t written = write(fds[1], line.data(), line.size());
+        std::remove("simulation.txt");
+        rmdir(dir);
+        _exit(written == (ssize_t)line.size() ? 0 : 3);
+    }
+    close(fds[1]);
+    if (pid < 0)
+    {
+        close(fds[0]);
+        return res;
+    }
+    std::string text;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+        text.append(buf, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return res;
+
+    std::istringstream in(text);
+    in >> res.ticks >> res.delivered >> res.wallUs >> res.rssKb >> res.phases.setup >> res.phases.spawn >>
+        res.phases.dispatch >> res.phases.movement >> res.phases.telemetry >> res.phases.render;
+    res.ok = (bool)in;
+    return res;
+}
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("cannot open " + path);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string baselinePath = "bench/baseline.json";
+    std::string writePath;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (arg == "--write" && i + 1 < argc)
+            writePath = argv[++i];
+        else
+            selected.push_back(arg);
+    }
+
+    std::vector<Scenario> scenarios;
+    double defaultTicksTol = 0.3, defaultRssTol = 0.25;
+    try
+    {
+        Json root = JsonParser(readFile(baselinePath)).parse();
+        if (const Json *tol = root.get("tolerance"))
+        {
+            defaultTicksTol = tol->num("ticks_per_sec", defaultTicksTol);
+            defaultRssTol = tol->num("peak_rss_mb", defaultRssTol);
+        }
+        const Json *list = root.get("scenarios");
+        if (!list || list->type != Json::Type::Array)
+            throw std::runtime_error("baseline has no \"scenarios\" array");
+        for (const Json &entry : list->array)
+        {
+            Scenario sc;
+            const Json *name = entry.get("name");
+            const Json *config = entry.get("config");
+            const Json *isDefault = entry.get("default");
+            if (!name || !config)
+                throw std::runtime_error("scenario without name or config");
+            sc.name = name->string;
+            sc.config = config->string;
+            sc.isDefault = isDefault && isDefault->boolean;
+            sc.ticksPerSec = entry.num("ticks_per_sec", 0);
+            sc.peakRssMb = entry.num("peak_rss_mb", 0);
+            sc.ticksTolerance = entry.num("ticks_per_sec_tolerance", defaultTicksTol);
+            sc.rssTolerance = entry.num("peak_rss_mb_tolerance", defaultRssTol);
+            scenarios.push_back(sc);
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << "\n";
+        return 2;
+    }
+
+    auto wanted = [&](const Scenario &sc) {
+        if (selected.empty())
+            return sc.isDefault;
+        for (const auto &s : selected)
+            if (s == sc.name || s == "all")
+                return true;
+        return false;
+    };
+
+    bool regressed = false;
+    std::ostringstream written;
+    written << "{\n  \"tolerance\": {\"ticks_per_sec\": " << defaultTicksTol << ", \"peak_rss_mb\": " << defaultRssTol
+            << "},\n  \"scenarios\": [";
+    bool first = true;
+    std::printf("%-8s %9s %12s %10s %9s | %9s %9s %9s %9s (ms)\n", "scenario", "ticks", "ticks/s", "rss MB",
+                "delivered", "setup", "spawn", "dispatch", "move");
+    for (Scenario &sc : scenarios)
+    {
+        double tps = sc.ticksPerSec, rss = sc.peakRssMb;
+        if (wanted(sc))
+        {
+            Result r = runScenario(sc);
+            if (!r.ok)
+            {
+                std::printf("%-8s FAILED\n", sc.name.c_str());
+                regressed = true;
+                continue;
+            }
+            tps = r.wallUs > 0 ? r.ticks * 1e6 / r.wallUs : 0;
+            rss = r.rssKb / 1024.0;
+            std::printf("%-8s %9lld %12.1f %10.1f %9lld | %9.1f %9.1f %9.1f %9.1f\n", sc.name.c_str(), r.ticks, tps,
+                        rss, r.delivered, r.phases.setup / 1e3, r.phases.spawn / 1e3, r.phases.dispatch / 1e3,
+                        r.phases.movement / 1e3);
+
+            if (sc.ticksPerSec <= 0)
+                std::printf("         no baseline recorded\n");
+            else
+            {
+                if (tps < sc.ticksPerSec * (1 - sc.ticksTolerance))
+                {
+                    std::printf("         REGRESSION: ticks/s %.1f below %.1f - %.0f%%\n", tps, sc.ticksPerSec,
+                                sc.ticksTolerance * 100);
+                    regressed = true;
+                }
+                if (rss > sc.peakRssMb * (1 + sc.rssTolerance))
+                {
+                    std::printf("         REGRESSION: peak RSS %.1f MB above %.1f + %.0f%%\n", rss, sc.peakRssMb,
+                                sc.rssTolerance * 100);
+                    regressed = true;
+                }
+            }
+        }
+        written << (first ? "" : ",") << "\n    {\"name\": \"" << sc.name << "\", \"config\": \"" << sc.config
+                << "\", \"default\": " << (sc.isDefault ? "true" : "false");
+        if (tps > 0)
+            written << ", \"ticks_per_sec\": " << (long long)tps << ", \"peak_rss_mb\": " << (long long)(rss + 0.5);
+        written << "}";
+        first = false;
+    }
+    written << "\n  ]\n}\n";
+
+    if (!writePath.empty())
+    {
+        std::ofstream out(writePath);
+        out << written.str();
+    }
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+// Fleet-sizing search.
+//
+//   hive_fleet [--config FILE] [--drones LO:HI[:STEP]] [--robots ...] [--scooters ...]
+//              [--stations ...] [--seeds N] [--max-seeds N] [--jobs N] [--eta X]
+//
+// Races every fleet mix in the given ranges (a field without a range keeps
+// the config's value) for the highest end-of-run profit, the figure
+// writeReport prints. Each replica is a headless run of the config with the
+// mix and a seed appended, in its own child process; up to --jobs run at
+// once. See FleetRace for how candidates are dropped between rounds.
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "FleetRace.h"
+#include "Simulation.h"
+
+namespace {
+
+struct Range {
+    int lo = -1, hi = -1, step = 1; // lo < 0: keep the config's value
+};
+
+Range parseRange(const std::string &text)
+{
+    Range r;
+    char sep;
+    std::istringstream in(text);
+    in >> r.lo;
+    r.hi = r.lo;
+    if (in >> sep && sep == ':')
+    {
+        in >> r.hi;
+        if (in >> sep && sep == ':')
+            in >> r.step;
+    }
+    if (!in.eof() || r.lo < 0 || r.hi < r.lo || r.step < 1)
+        throw std::runtime_error("bad range '" + text + "' (expected LO:HI[:STEP])");
+    return r;
+}
+
+std::vector<int> values(const Range &r)
+{
+    std::vector<int> v;
+    if (r.lo < 0)
+        v.push_back(-1);
+    else
+        for (int x = r.lo; x <= r.hi; x += r.step)
+            v.push_back(x);
+    return v;
+}
+
+struct Replica {
+    pid_t pid = -1;
+    int fd = -1;
+    int candidate = 0;
+    int seedIndex = 0;
+};
+
+// Forks a headless run of `configText` plus the candidate's overrides.
+Replica launch(const std::string &configText, const FleetCandidate &c, long long seed, int candidate, int seedIndex)
+{
+    Replica r;
+    r.candidate = candidate;
+    r.seedIndex = seedIndex;
+    int fds[2];
+    if (pipe(fds) != 0)
+        return r;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        char dir[] = "/tmp/hive_fleet_XXXXXX";
+        int devnull = open("/dev/null", O_WRONLY);
+        if (!mkdtemp(dir) || chdir(dir) != 0 || devnull < 0)
+            _exit(2);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        {
+            // later config lines override earlier ones
+            std::ofstream cfg("fleet.txt");
+            cfg << configText << "\n";
+            if (c.drones >= 0)
+                cfg << "DRONES: " << c.drones << "\n";
+            if (c.robots >= 0)
+                cfg << "ROBOTS: " << c.robots << "\n";
+            if (c.scooters >= 0)
+                cfg << "SCOOTERS: " << c.scooters << "\n";
+            if (c.stations >= 0)
+                cfg << "MAX_STATIONS: " << c.stations << "\n";
+            cfg << "SEED: " << seed << "\nHEADLESS: 1\nDISPLAY_DELAY_MS: 0\n";
+        }
+        long long profit = 0;
+        {
+            Simulation sim("fleet.txt");
+            sim.run();
+            profit = sim.getLedger().finalProfit();
+        }
+        const std::string line = std::to_string(profit) + "\n";
+        ssize_t written = write(fds[1], line.data(), line.size());
+        std::remove("fleet.txt");
+        std::remove("simulation.txt");
+        rmdir(dir);
+        _exit(written == (ssize_t)line.size() ? 0 : 3);
+    }
+    close(fds[1]);
+    if (pid < 0)
+    {
+        close(fds[0]);
+        return r;
+    }
+    r.pid = pid;
+    r.fd = fds[0];
+    return r;
+}
+
+// Waits for any replica to finish; false if it failed. Losing track of the
+// children (a waitpid error, or a pid that is not one of ours) is not a
+// replica failure and throws instead.
+bool reap(std::vector<Replica> &running, Replica &done, double &profit)
+{
+    int status = 0;
+    pid_t pid;
+    do
+        pid = waitpid(-1, &status, 0);
+    while (pid < 0 && errno == EINTR);
+    if (pid < 0)
+        throw std::runtime_error(std::string("waitpid: ") + std::strerror(errno));
+    auto it = std::find_if(running.begin(), running.end(), [pid](const Replica &r) { return r.pid == pid; });
+    if (it == running.end())
+        throw std::runtime_error("reaped unknown child " + std::to_string(pid));
+    done = *it;
+    running.erase(it);
+    std::string text;
+    char buf[64];
+    ssize_t n;
+    while ((n = read(done.fd, buf, sizeof(buf))) > 0)
+        text.append(buf, n);
+    close(done.fd);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || text.empty())
+        return false;
+    profit = std::atof(text.c_str());
+    return true;
+}
+
+std::string describe(const FleetCandidate &c)
+{
+    std::ostringstream out;
+    auto field = [&out](const char *name, int v) {
+        if (v >= 0)
+            out << name << "=" << v << " ";
+    };
+    field("drones", c.drones);
+    field("robots", c.robots);
+    field("scooters", c.scooters);
+    field("stations", c.stations);
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string configPath = "simulation_setup.txt";
+    Range ranges[4]; // drones, robots, scooters, stations
+    int initialSeeds = 2, maxSeeds = 16;
+    int jobs = (int)std::max(1u, std::thread::hardware_concurrency());
+    double eta = 2.0;
+    long long baseSeed = 1;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::runtime_error(arg + " needs a value");
+                return argv[++i];
+            };
+            if (arg == "--config")
+                configPath = next();
+            else if (arg == "--drones")
+                ranges[0] = parseRange(next());
+            else if (arg == "--robots")
+                ranges[1] = parseRange(next());
+            else if (arg == "--scooters")
+                ranges[2] = parseRange(next());
+            else if (arg == "--stations")
+                ranges[3] = parseRange(next());
+            else if (arg == "--seeds")
+                initialSeeds = std::atoi(next().c_str());
+            else if (arg == "--max-seeds")
+                maxSeeds = std::atoi(next().c_str());
+            else if (arg == "--jobs")
+                jobs = std::max(1, std::atoi(next().c_str()));
+            else if (arg == "--eta")
+                eta = std::atof(next().c_str());
+            else if (arg == "--base-seed")
+                baseSeed = std::atoll(next().c_str());
+            else
+                throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "hive_fleet: " << ex.what() << "\n";
+        return 2;
+    }
+
+    std::ifstream in(configPath);
+    if (!in)
+    {
+        std::cerr << "hive_fleet: cannot open " << configPath << "\n";
+        return 2;
+    }
+    std::ostringstream configText;
+    configText << in.rdbuf();
+
+    std::vector<FleetCandidate> candidates;
+    for (int d : values(ranges[0]))
+        for (int r : values(ranges[1]))
+            for (int s : values(ranges[2]))
+                for (int m : values(ranges[3]))
+                {
+                    FleetCandidate c;
+                    c.drones = d;
+                    c.robots = r;
+                    c.scooters = s;
+                    c.stations = m;
+                    candidates.push_back(c);
+                }
+    const size_t exhaustive = candidates.size() * (size_t)std::max(1, maxSeeds);
+    FleetRace race(std::move(candidates), initialSeeds, maxSeeds, eta);
+
+    size_t replicas = 0, failures = 0;
+    do
+    {
+        std::vector<std::pair<int, int>> runs = race.pendingRuns();
+        std::vector<Replica> running;
+        size_t launched = 0;
+        while (launched < runs.size() || !running.empty())
+        {
+            while (launched < runs.size() && (int)running.size() < jobs)
+            {
+                const auto [cand, seedIndex] = runs[launched++];
+                Replica r = launch(configText.str(), race.candidates()[cand], baseSeed + seedIndex, cand, seedIndex);
+                if (r.pid < 0)
+                {
+                    std::cerr << "hive_fleet: fork failed\n";
+                    return 1;
+                }
+                running.push_back(r);
+            }
+            Replica done;
+            double profit = 0;
+            bool ok;
+            try
+            {
+                ok = reap(running, done, profit);
+            }
+            catch (const std::exception &ex)
+            {
+                std::cerr << "hive_fleet: " << ex.what() << "\n";
+                return 1;
+            }
+            if (ok)
+                race.record(done.candidate, done.seedIndex, profit);
+            else
+            {
+                // a crash has no profit to compare; drop the mix rather than score it
+                ++failures;
+                race.recordCrash(done.candidate);
+            }
+            ++replicas;
+        }
+        int alive = 0;
+        for (const FleetCandidate &c : race.candidates())
+            alive += c.alive();
+        if (race.leader() < 0)
+        {
+            std::printf("round %d: every candidate crashed\n", race.round());
+            break;
+        }
+        std::printf("round %d: %d candidates x %d seeds, leader %s(mean profit %.0f)\n", race.round(), alive,
+                    race.seedsThisRound(), describe(race.candidates()[race.leader()]).c_str(),
+                    race.candidates()[race.leader()].mean());
+        std::fflush(stdout);
+    } while (race.nextRound());
+
+    std::vector<int> order;
+    for (size_t i = 0; i < race.candidates().size(); ++i)
+        order.push_back((int)i);
+    std::sort(order.begin(), order.end(), [&race](int a, int b) {
+        const FleetCandidate &x = race.candidates()[a], &y = race.candidates()[b];
+        if (x.alive() != y.alive())
+            return x.alive();
+        if (x.eliminatedInRound != y.eliminatedInRound)
+            return x.eliminatedInRound > y.eliminatedInRound;
+        return x.mean() > y.mean();
+    });
+    std::printf("\n%-44s %6s %12s %10s %s\n", "candidate", "seeds", "mean profit", "stderr", "status");
+    for (size_t k = 0; k < order.size() && k < 10; ++k)
+    {
+        const FleetCandidate &c = race.candidates()[order[k]];
+        double var = 0;
+        size_t n = 0;
+        for (double p : c.profits)
+        {
+            if (std::isnan(p))
+                continue;
+            var += (p - c.mean()) * (p - c.mean());
+            ++n;
+        }
+        const double se = n > 1 ? std::sqrt(var / (n - 1) / n) : 0;
+        std::string status = c.alive() ? "finalist" : "dropped in round " + std::to_string(c.eliminatedInRound);
+        if (c.crashes)
+            status += " (" + std::to_string(c.crashes) + " crashed)";
+        std::printf("%-44s %6zu %12.0f %10.0f %s\n", describe(c).c_str(), n, c.mean(), se, status.c_str());
+    }
+    std::printf("\n%zu replicas (%zu failed) instead of %zu for every candidate on %d seeds\n", replicas, failures,
+                exhaustive, maxSeeds);
+    return 0;
+}
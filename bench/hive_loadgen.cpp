@@ -0,0 +1,220 @@
+// Load generator for service mode (SERVICE_SOCKET:).
+//
+//   hive_loadgen --socket PATH [--clients N] [--rate R] [--seconds S] [--shutdown]
+//
+// Opens N connections, each submitting orders to random client cells of the
+// served map at R/N orders per second for S seconds, one request in flight
+// per connection. Prints how many were queued or rejected, the round-trip
+// percentiles seen by the clients, and the service's own STATUS and
+// submission-to-assignment LATENCY. --shutdown stops the service afterwards.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+namespace {
+
+class Connection {
+public:
+    explicit Connection(const std::string &path)
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd >= 0 && connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~Connection()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+    bool ok() const { return fd >= 0; }
+
+    // sends one request line and returns the reply line ("" on failure)
+    std::string request(const std::string &line)
+    {
+        std::string msg = line + "\n";
+        if (send(fd, msg.data(), msg.size(), MSG_NOSIGNAL) != (ssize_t)msg.size())
+            return "";
+        size_t eol;
+        while ((eol = buffer.find('\n')) == std::string::npos)
+        {
+            char buf[4096];
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return "";
+            buffer.append(buf, n);
+        }
+        std::string reply = buffer.substr(0, eol);
+        buffer.erase(0, eol + 1);
+        return reply;
+    }
+
+private:
+    int fd = -1;
+    std::string buffer;
+};
+
+struct Tally {
+    long long queued = 0;
+    long long rejected = 0;
+    long long errors = 0;
+    LatencyHistogram rtt;
+};
+
+long long nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string path;
+    int connections = 4;
+    double rate = 200;
+    double seconds = 5;
+    bool shutdown = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+            path = argv[++i];
+        else if (arg == "--clients" && i + 1 < argc)
+            connections = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rate" && i + 1 < argc)
+            rate = std::atof(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc)
+            seconds = std::atof(argv[++i]);
+        else if (arg == "--shutdown")
+            shutdown = true;
+        else
+        {
+            std::fprintf(stderr, "usage: %s --socket PATH [--clients N] [--rate R] [--seconds S] [--shutdown]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty() || rate <= 0)
+    {
+        std::fprintf(stderr, "a socket path and a positive rate are required\n");
+        return 2;
+    }
+
+    Connection control(path);
+    if (!control.ok())
+    {
+        std::fprintf(stderr, "cannot connect to %s\n", path.c_str());
+        return 1;
+    }
+    std::vector<std::pair<int, int>> cells;
+    {
+        std::istringstream in(control.request("CLIENTS"));
+        std::string tag;
+        size_t n = 0;
+        in >> tag >> n;
+        int x, y;
+        while (cells.size() < n && in >> x >> y)
+            cells.push_back({x, y});
+    }
+    if (cells.empty())
+    {
+        std::fprintf(stderr, "the service reported no client cells\n");
+        return 1;
+    }
+
+    std::vector<Tally> tallies(connections);
+    std::vector<std::thread> threads;
+    const long long intervalUs = (long long)(1e6 * connections / rate);
+    const long long endUs = nowUs() + (long long)(seconds * 1e6);
+    for (int t = 0; t < connections; ++t)
+    {
+        threads.emplace_back([&, t] {
+            Connection conn(path);
+            Tally &tally = tallies[t];
+            if (!conn.ok())
+            {
+                ++tally.errors;
+                return;
+            }
+            std::mt19937 rng(1234 + t);
+            std::uniform_int_distribution<size_t> pick(0, cells.size() - 1);
+            std::uniform_int_distribution<int> reward(200, 800);
+            std::uniform_int_distribution<int> deadline(10, 20);
+            long long next = nowUs() + intervalUs * t / connections; // stagger the connections
+            while (next < endUs)
+            {
+                long long wait = next - nowUs();
+                if (wait > 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(wait));
+                const auto &cell = cells[pick(rng)];
+                std::ostringstream req;
+                req << "SUBMIT " << cell.first << ' ' << cell.second << ' ' << reward(rng) << ' ' << deadline(rng);
+                long long sent = nowUs();
+                std::string reply = conn.request(req.str());
+                tally.rtt.record(nowUs() - sent);
+                if (reply == "QUEUED")
+                    ++tally.queued;
+                else if (reply.rfind("REJECTED", 0) == 0)
+                    ++tally.rejected;
+                else
+                {
+                    ++tally.errors;
+                    if (reply.empty())
+                        return; // connection lost
+                }
+                next += intervalUs;
+            }
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+
+    Tally total;
+    for (const auto &t : tallies)
+    {
+        total.queued += t.queued;
+        total.rejected += t.rejected;
+        total.errors += t.errors;
+    }
+    // per-connection histograms only merge approximately; report the worst
+    long long p50 = 0, p99 = 0, max = 0;
+    for (const auto &t : tallies)
+    {
+        p50 = std::max(p50, t.rtt.percentile(0.5));
+        p99 = std::max(p99, t.rtt.percentile(0.99));
+        max = std::max(max, t.rtt.max());
+    }
+    std::printf("submitted %lld: queued %lld, rejected %lld, errors %lld\n", total.queued + total.rejected + total.errors,
+                total.queued, total.rejected, total.errors);
+    std::printf("round trip (us, worst connection): p50=%lld p99=%lld max=%lld\n", p50, p99, max);
+
+    // give the service a couple of ticks to assign the last submissions
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    std::printf("%s\n", control.request("STATUS").c_str());
+    std::printf("%s (submission to assignment, us)\n", control.request("LATENCY").c_str());
+    if (shutdown)
+        std::printf("%s\n", control.request("SHUTDOWN").c_str());
+    return total.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// Monitor for the live state a run publishes under SHARED_STATE:.
+//
+//   hive_watch [--name /hive] [--interval MS] [--frames N] [--couriers]
+//
+// Polls the segment every MS milliseconds (default 200) and prints one line
+// per new tick: waiting pool, deliveries, deaths, active couriers and the
+// provisional profit; --couriers adds each courier's position, type and
+// battery. Stops after N printed frames, or when the run closes the segment.
+// Reads never lock or slow the simulation; the torn copies it had to retry
+// are reported at the end.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SharedState.h"
+
+namespace {
+
+void usage()
+{
+    std::fprintf(stderr, "usage: hive_watch [--name /hive] [--interval MS] [--frames N] [--couriers]\n");
+}
+
+const char *kindName(uint8_t kind)
+{
+    static const char *names[] = {"drone", "robot", "scooter"};
+    return kind < 3 ? names[kind] : "?";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string name = "/hive";
+    int intervalMs = 200;
+    long long maxFrames = -1;
+    bool showCouriers = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc)
+            name = argv[++i];
+        else if (arg == "--interval" && i + 1 < argc)
+            intervalMs = std::atoi(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc)
+            maxFrames = std::atoll(argv[++i]);
+        else if (arg == "--couriers")
+            showCouriers = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    try
+    {
+        StateReader reader(name);
+        SharedFrame frame{};
+        std::vector<SharedCourier> couriers;
+        long long printed = 0;
+        int lastTick = -1;
+        while (maxFrames < 0 || printed < maxFrames)
+        {
+            const bool live = reader.live(); // before the read, so the last frame is not missed
+            if (reader.read(frame, couriers) && frame.tick != lastTick)
+            {
+                lastTick = frame.tick;
+                ++printed;
+                std::printf("tick %d  waiting %d  delivered %d/%d (late %d)  dead %d  active %d  carrying %d  "
+                            "profit %lld\n",
+                            frame.tick, frame.waiting, frame.delivered, frame.spawned, frame.deliveredLate,
+                            frame.deadAgents, frame.activeCouriers, frame.carryingCouriers,
+                            (long long)frame.profit);
+                if (showCouriers)
+                    for (size_t i = 0; i < couriers.size(); ++i)
+                    {
+                        const SharedCourier &c = couriers[i];
+                        std::printf("  #%zu %-7s (%d,%d) battery %d/%d%s%s\n", i, kindName(c.kind), c.x, c.y,
+                                    c.battery, c.maxBattery, c.carrying ? " carrying" : "",
+                                    c.dead ? " dead" : "");
+                    }
+                std::fflush(stdout);
+            }
+            if (!live)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        }
+        std::printf("%lld frames, %lld torn reads retried\n", printed, reader.retries());
+    }
+    catch (const std::exception &ex)
+    {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "AllocTracker.h"
+
+#include <sys/resource.h>
+
+long long AllocTracker::peakRssKb()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+    return ru.ru_maxrss; // kilobytes on Linux
+}
+
+#ifdef HIVE_ALLOC_TRACKING
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+// trivially constructible and destructible, so touching it from operator new
+// never runs TLS initialisation that could allocate in turn
+thread_local AllocCounts AllocTracker::threadCounts;
+
+namespace {
+
+void *countedAlloc(std::size_t n, std::size_t align, bool nothrow)
+{
+    void *p = nullptr;
+    if (align <= alignof(std::max_align_t))
+        p = std::malloc(n ? n : 1);
+    else if (posix_memalign(&p, align, n ? n : 1) != 0)
+        p = nullptr;
+    if (!p)
+    {
+        if (nothrow)
+            return nullptr;
+        throw std::bad_alloc();
+    }
+    AllocCounts &c = AllocTracker::threadCounts;
+    ++c.allocations;
+    c.bytes += (long long)n;
+    return p;
+}
+
+void countedFree(void *p) noexcept
+{
+    if (!p)
+        return;
+    ++AllocTracker::threadCounts.frees;
+    std::free(p);
+}
+
+} // namespace
+
+void *operator new(std::size_t n) { return countedAlloc(n, 0, false); }
+void *operator new[](std::size_t n) { return countedAlloc(n, 0, false); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return countedAlloc(n, 0, true); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return countedAlloc(n, 0, true); }
+void *operator new(std::size_t n, std::align_val_t a) { return countedAlloc(n, (std::size_t)a, false); }
+void *operator new[](std::size_t n, std::align_val_t a) { return countedAlloc(n, (std::size_t)a, false); }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(n, (std::size_t)a, true);
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(n, (std::size_t)a, true);
+}
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete(void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { countedFree(p); }
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+// Heap allocation accounting. Builds with ALLOC_TRACKING=1 (which defines
+// HIVE_ALLOC_TRACKING) replace the global operator new/delete with versions
+// that count into plain thread-local counters: no locks, no atomics, and
+// exact per-thread numbers. In other builds every count stays zero.
+
+struct AllocCounts {
+    long long allocations = 0;
+    long long frees = 0;
+    long long bytes = 0; // requested by the allocations
+
+    AllocCounts& operator+=(const AllocCounts& o)
+    {
+        allocations += o.allocations;
+        frees += o.frees;
+        bytes += o.bytes;
+        return *this;
+    }
+    AllocCounts operator-(const AllocCounts& o) const
+    {
+        return {allocations - o.allocations, frees - o.frees, bytes - o.bytes};
+    }
+};
+
+namespace AllocTracker {
+
+#ifdef HIVE_ALLOC_TRACKING
+constexpr bool compiledIn = true;
+extern thread_local AllocCounts threadCounts;
+inline AllocCounts thisThread() { return threadCounts; }
+// adds allocations another thread made on this thread's behalf
+inline void credit(const AllocCounts& c) { threadCounts += c; }
+#else
+constexpr bool compiledIn = false;
+inline AllocCounts thisThread() { return {}; }
+inline void credit(const AllocCounts&) {}
+#endif
+
+// counts since `mark`, which moves up to now
+inline AllocCounts lap(AllocCounts& mark)
+{
+    const AllocCounts now = thisThread();
+    const AllocCounts d = now - mark;
+    mark = now;
+    return d;
+}
+
+long long peakRssKb(); // of the process, from getrusage
+
+} // namespace AllocTracker
@@ -0,0 +1,184 @@
+#include "Assignment.h"
+
+#include <algorithm>
+#include <numeric>
+
+static bool expired(Deadline deadline)
+{
+    return deadline != Deadline::max() && std::chrono::steady_clock::now() >= deadline;
+}
+
+namespace {
+
+// working arrays reused across calls on the same thread
+struct Scratch {
+    std::vector<long long> u, v, minv;
+    std::vector<int> p, way, order;
+    std::vector<char> used;
+};
+thread_local Scratch scratch;
+
+} // namespace
+
+bool hungarianAssign(const CostMatrix &a, std::vector<int> &match, Deadline deadline)
+{
+    int n = (int)a.size();
+    const long long INF = (long long)4e15;
+    std::vector<long long> &u = scratch.u, &v = scratch.v, &minv = scratch.minv;
+    std::vector<int> &p = scratch.p, &way = scratch.way;
+    std::vector<char> &used = scratch.used;
+    u.assign(n + 1, 0);
+    v.assign(n + 1, 0);
+    p.assign(n + 1, 0);
+    way.assign(n + 1, 0);
+    minv.resize(n + 1);
+    used.resize(n + 1);
+    for (int i = 1; i <= n; ++i)
+    {
+        if (expired(deadline))
+            return false;
+        p[0] = i;
+        int j0 = 0;
+        std::fill(minv.begin(), minv.end(), INF);
+        std::fill(used.begin(), used.end(), false);
+        do
+        {
+            used[j0] = true;
+            int i0 = p[j0];
+            int j1 = 0;
+            long long delta = INF;
+            for (int j = 1; j <= n; ++j)
+            {
+                if (used[j])
+                    continue;
+                long long cur = a[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j])
+                {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta)
+                {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; ++j)
+            {
+                if (used[j])
+                {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do
+        {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    match.assign(n, -1);
+    for (int j = 1; j <= n; ++j)
+    {
+        if (p[j] != 0)
+            match[p[j] - 1] = j - 1;
+    }
+    return true;
+}
+
+bool greedyAssign(const CostMatrix &a, std::vector<int> &match, Deadline deadline)
+{
+    const int n = (int)a.size();
+    match.assign(n, -1);
+    std::vector<long long> &cheapest = scratch.minv;
+    cheapest.resize(n);
+    for (int i = 0; i < n; ++i)
+        cheapest[i] = *std::min_element(a[i], a[i] + n);
+    std::vector<int> &order = scratch.order;
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    // ties broken by row: the stable order without stable_sort's buffer
+    std::sort(order.begin(), order.end(), [&](int x, int y) {
+        return cheapest[x] < cheapest[y] || (cheapest[x] == cheapest[y] && x < y);
+    });
+
+    std::vector<char> &taken = scratch.used;
+    taken.assign(n, false);
+    for (int i : order)
+    {
+        if (expired(deadline))
+            return false;
+        int best = -1;
+        for (int j = 0; j < n; ++j)
+            if (!taken[j] && (best < 0 || a[i][j] < a[i][best]))
+                best = j;
+        match[i] = best;
+        taken[best] = true;
+    }
+    return true;
+}
+
+bool improveAssignment(const CostMatrix &a, std::vector<int> &match, Deadline deadline)
+{
+    const int n = (int)a.size();
+    std::vector<int> &freeCols = scratch.p;
+    freeCols.clear();
+    {
+        std::vector<char> &taken = scratch.used;
+        taken.assign(n, false);
+        for (int j : match)
+            if (j >= 0)
+                taken[j] = true;
+        for (int j = 0; j < n; ++j)
+            if (!taken[j])
+                freeCols.push_back(j);
+    }
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+        for (int i = 0; i < n; ++i)
+        {
+            if (expired(deadline))
+                return false;
+            if (match[i] < 0)
+                continue;
+            for (int k = i + 1; k < n; ++k)
+            {
+                const int ci = match[i], ck = match[k];
+                if (ck < 0)
+                    continue;
+                if (a[i][ck] + a[k][ci] < a[i][ci] + a[k][ck])
+                {
+                    std::swap(match[i], match[k]);
+                    improved = true;
+                }
+            }
+            for (int &f : freeCols)
+            {
+                if (a[i][f] < a[i][match[i]])
+                {
+                    std::swap(match[i], f);
+                    improved = true;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+long long assignmentCost(const CostMatrix &a, const std::vector<int> &match)
+{
+    long long total = 0;
+    for (size_t i = 0; i < match.size(); ++i)
+        if (match[i] >= 0)
+            total += a[i][match[i]];
+    return total;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Min-cost assignment over a square cost matrix (rows = packages, columns =
+// courier slots, padded with zero-cost dummies). A match maps row -> column,
+// -1 for a row left out. The solvers keep their working arrays per thread,
+// so repeated rounds do not allocate once the largest size has been seen.
+
+// n x n row-major view over caller-owned cells (e.g. carved from a TickArena)
+struct CostMatrix {
+    long long* cells = nullptr;
+    int n = 0;
+
+    int size() const { return n; }
+    long long* operator[](int row) const { return cells + (size_t)row * n; }
+};
+using Deadline = std::chrono::steady_clock::time_point;
+
+// Exact solution (Hungarian, O(n^3)). Returns false and leaves `match`
+// untouched if the deadline passes first.
+bool hungarianAssign(const CostMatrix& a, std::vector<int>& match, Deadline deadline = Deadline::max());
+
+// O(n^2) greedy: rows in order of their cheapest entry each take their
+// cheapest free column. Rows not reached by the deadline stay at -1.
+// Returns false if cut short.
+bool greedyAssign(const CostMatrix& a, std::vector<int>& match, Deadline deadline);
+
+// Pairwise-exchange local search: swaps columns between two rows, or moves a
+// row to a free column, while that lowers the total cost. Returns false if
+// the deadline passed before no improving move was left.
+bool improveAssignment(const CostMatrix& a, std::vector<int>& match, Deadline deadline);
+
+long long assignmentCost(const CostMatrix& a, const std::vector<int>& match);
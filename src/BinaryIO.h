@@ -0,0 +1,86 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "Errors.h"
+
+// Minimal helpers for the binary snapshot format. Values are written in host
+// byte order; snapshots are meant to be restored on the machine that wrote them.
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::ostream& out) : out(out) {}
+
+    template <typename T>
+    void pod(const T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "pod() needs a trivially copyable type");
+        out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void str(const std::string& s)
+    {
+        pod<uint32_t>((uint32_t)s.size());
+        out.write(s.data(), (std::streamsize)s.size());
+    }
+
+    template <typename T>
+    void podVector(const std::vector<T>& v)
+    {
+        pod<uint32_t>((uint32_t)v.size());
+        if (!v.empty())
+            out.write(reinterpret_cast<const char*>(v.data()), (std::streamsize)(v.size() * sizeof(T)));
+    }
+
+private:
+    std::ostream& out;
+};
+
+class BinaryReader {
+public:
+    explicit BinaryReader(std::istream& in) : in(in) {}
+
+    template <typename T>
+    T pod()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "pod() needs a trivially copyable type");
+        T v{};
+        in.read(reinterpret_cast<char*>(&v), sizeof(T));
+        check();
+        return v;
+    }
+
+    std::string str()
+    {
+        uint32_t n = pod<uint32_t>();
+        std::string s(n, '\0');
+        if (n)
+            in.read(&s[0], n);
+        check();
+        return s;
+    }
+
+    template <typename T>
+    std::vector<T> podVector()
+    {
+        uint32_t n = pod<uint32_t>();
+        std::vector<T> v(n);
+        if (n)
+            in.read(reinterpret_cast<char*>(v.data()), (std::streamsize)(n * sizeof(T)));
+        check();
+        return v;
+    }
+
+private:
+    void check()
+    {
+        if (!in)
+            throw SnapshotError("Snapshot is truncated or unreadable\n");
+    }
+
+    std::istream& in;
+};
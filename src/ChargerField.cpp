@@ -0,0 +1,115 @@
+#include "ChargerField.h"
+
+#include <algorithm>
+
+ChargerField::ChargerField(const MapData &map)
+    : rows((int)map.grid.size()),
+      cols(map.grid.empty() ? 0 : (int)map.grid[0].size())
+{
+    sites.push_back(map.basePos);
+    sites.insert(sites.end(), map.stations.begin(), map.stations.end());
+    buildGround(map.grid);
+    buildAir();
+}
+
+void ChargerField::buildGround(const std::vector<std::string> &grid)
+{
+    const int n = rows * cols;
+    ground.dist.assign(n, -1);
+    ground.owner.assign(n, 0);
+
+    // BFS outwards from all chargers at once. A step u -> v in the search is
+    // the move v -> u on the map, so it only needs u to be enterable.
+    std::vector<int> queue;
+    queue.reserve(n);
+    for (size_t s = 0; s < sites.size(); ++s)
+    {
+        int idx = index(sites[s]);
+        if (ground.dist[idx] == 0)
+            continue; // duplicate site
+        ground.dist[idx] = 0;
+        ground.owner[idx] = (int32_t)s;
+        queue.push_back(idx);
+    }
+    static const int dr[4] = {1, -1, 0, 0};
+    static const int dc[4] = {0, 0, 1, -1};
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        const int u = queue[head];
+        const int ur = u / cols, uc = u % cols;
+        if (grid[ur][uc] == '#')
+            continue; // reached, but nobody can step into it
+        for (int k = 0; k < 4; ++k)
+        {
+            const int vr = ur + dr[k], vc = uc + dc[k];
+            if (vr < 0 || vr >= rows || vc < 0 || vc >= cols)
+                continue;
+            const int v = vr * cols + vc;
+            if (ground.dist[v] >= 0)
+                continue;
+            ground.dist[v] = ground.dist[u] + 1;
+            ground.owner[v] = ground.owner[u];
+            queue.push_back(v);
+        }
+    }
+}
+
+void ChargerField::buildAir()
+{
+    // Rosenfeld-Pfaltz city-block transform: a forward and a backward raster
+    // pass with the 4-neighbour mask give exact L1 distances.
+    const int n = rows * cols;
+    const int32_t far = rows + cols + 1;
+    air.dist.assign(n, far);
+    air.owner.assign(n, 0);
+    for (size_t s = 0; s < sites.size(); ++s)
+    {
+        int idx = index(sites[s]);
+        if (air.dist[idx] == 0)
+            continue;
+        air.dist[idx] = 0;
+        air.owner[idx] = (int32_t)s;
+    }
+    int32_t *d = air.dist.data();
+    int32_t *o = air.owner.data();
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            const int i = r * cols + c;
+            if (r > 0 && d[i - cols] + 1 < d[i])
+            {
+                d[i] = d[i - cols] + 1;
+                o[i] = o[i - cols];
+            }
+            if (c > 0 && d[i - 1] + 1 < d[i])
+            {
+                d[i] = d[i - 1] + 1;
+                o[i] = o[i - 1];
+            }
+        }
+    }
+    for (int r = rows - 1; r >= 0; --r)
+    {
+        for (int c = cols - 1; c >= 0; --c)
+        {
+            const int i = r * cols + c;
+            if (r + 1 < rows && d[i + cols] + 1 < d[i])
+            {
+                d[i] = d[i + cols] + 1;
+                o[i] = o[i + cols];
+            }
+            if (c + 1 < cols && d[i + 1] + 1 < d[i])
+            {
+                d[i] = d[i + 1] + 1;
+                o[i] = o[i + 1];
+            }
+        }
+    }
+}
+
+size_t ChargerField::memoryBytes() const
+{
+    return (ground.dist.size() + ground.owner.size() + air.dist.size() + air.owner.size()) * sizeof(int32_t) +
+           sites.size() * sizeof(Vec2);
+}
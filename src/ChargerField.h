@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "MapData.h"
+
+// Distance from every cell to its nearest charger (the stations and the
+// base), with the owning charger, i.e. a Voronoi partition of the map.
+// Built once per map in O(cells): a multi-source BFS for ground couriers
+// (same movement rules as DStarLite: any cell may be left, only non-'#'
+// cells entered) and a two-pass L1 distance transform for flying ones.
+// Lookups are O(1), which lets dispatch and movement plan charging stops
+// without extra path queries.
+class ChargerField {
+public:
+    explicit ChargerField(const MapData& map);
+
+    // Steps to the nearest charger, -1 if none is reachable.
+    int distance(Vec2 cell, bool flying) const
+    {
+        return layer(flying).dist[index(cell)];
+    }
+    // Position of that charger; only meaningful when distance() >= 0.
+    Vec2 nearest(Vec2 cell, bool flying) const
+    {
+        return sites[layer(flying).owner[index(cell)]];
+    }
+    const std::vector<Vec2>& chargers() const { return sites; }
+    size_t memoryBytes() const;
+
+private:
+    struct Layer {
+        std::vector<int32_t> dist;
+        std::vector<int32_t> owner; // index into sites
+    };
+
+    int index(Vec2 cell) const { return cell.x * cols + cell.y; }
+    const Layer& layer(bool flying) const { return flying ? air : ground; }
+    void buildGround(const std::vector<std::string>& grid);
+    void buildAir();
+
+    int rows, cols;
+    std::vector<Vec2> sites; // base first, then stations
+    Layer ground, air;
+};
@@ -0,0 +1,566 @@
+#include "ContractionHierarchy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+namespace
+{
+const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+constexpr int INF = 1 << 29;
+// witness searches give up after settling this many nodes and keep the
+// shortcut: never wrong, only a few more edges. Ordering only needs an
+// estimate, so it searches less than the actual contraction.
+constexpr int witnessSettleLimit = 256;
+constexpr int estimateSettleLimit = 24;
+
+using Entry = std::pair<int, int>; // (distance, node)
+using MinHeap = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+
+// per-thread query state; stamps make a reset O(1)
+struct SearchSpace {
+    std::vector<int> dist[2];
+    std::vector<int> parent[2]; // previous junction, -1 at a seed
+    std::vector<int> side[2];   // seed endpoint the node was reached from
+    std::vector<unsigned> stamp[2];
+    unsigned now = 0;
+
+    void prepare(size_t n)
+    {
+        if (dist[0].size() < n)
+        {
+            for (int d = 0; d < 2; ++d)
+            {
+                dist[d].resize(n);
+                parent[d].resize(n);
+                side[d].resize(n);
+                stamp[d].resize(n, 0);
+            }
+        }
+        if (++now == 0) // wrapped: forget every old stamp
+        {
+            for (int d = 0; d < 2; ++d)
+                std::fill(stamp[d].begin(), stamp[d].end(), 0);
+            now = 1;
+        }
+    }
+    int get(int d, int v) const { return stamp[d][v] == now ? dist[d][v] : INF; }
+    void set(int d, int v, int value, int from, int s)
+    {
+        stamp[d][v] = now;
+        dist[d][v] = value;
+        parent[d][v] = from;
+        side[d][v] = s;
+    }
+};
+thread_local SearchSpace space;
+} // namespace
+
+ContractionHierarchy::ContractionHierarchy(const std::vector<std::string> &grid)
+    : rows((int)grid.size()), cols(grid.empty() ? 0 : (int)grid[0].size())
+{
+    auto started = std::chrono::steady_clock::now();
+    compressCorridors(grid);
+
+    // junction graph: one undirected edge per corridor, the shortest of parallels
+    std::vector<std::vector<Edge>> graph(junctionCell.size());
+    auto addEdge = [&graph](int u, int v, int w, int mid, int corridor) {
+        for (Edge &e : graph[u])
+        {
+            if (e.to == v)
+            {
+                if (w < e.weight)
+                    e = Edge{v, w, mid, corridor};
+                return;
+            }
+        }
+        graph[u].push_back(Edge{v, w, mid, corridor});
+    };
+    for (size_t c = 0; c < corridors.size(); ++c)
+    {
+        const Corridor &cor = corridors[c];
+        if (cor.a == cor.b)
+            continue; // a loop never shortens a trip between junctions
+        const int w = (int)cor.inner.size() + 1;
+        addEdge(cor.a, cor.b, w, -1, (int)c);
+        addEdge(cor.b, cor.a, w, -1, (int)c);
+    }
+    contract(graph);
+    buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+void ContractionHierarchy::compressCorridors(const std::vector<std::string> &grid)
+{
+    const int n = rows * cols;
+    cellRef.assign(n, CellRef{});
+    auto passable = [&](int r, int c) { return r >= 0 && c >= 0 && r < rows && c < cols && grid[r][c] != '#'; };
+    auto degree = [&](int cell) {
+        int d = 0;
+        for (auto &dir : dirs)
+            d += passable(cell / cols + dir[0], cell % cols + dir[1]);
+        return d;
+    };
+    auto makeJunction = [&](int cell) {
+        cellRef[cell].junction = (int)junctionCell.size();
+        junctionCell.push_back(cell);
+    };
+    for (int cell = 0; cell < n; ++cell)
+    {
+        if (grid[cell / cols][cell % cols] == '#')
+            continue;
+        ++passableCells;
+        if (degree(cell) != 2)
+            makeJunction(cell);
+    }
+
+    // walk every corridor leaving junction j
+    auto walk = [&](int j) {
+        const int start = junctionCell[j];
+        for (auto &dir : dirs)
+        {
+            const int r = start / cols + dir[0], c = start % cols + dir[1];
+            if (!passable(r, c))
+                continue;
+            int cur = r * cols + c;
+            if (cellRef[cur].junction >= 0)
+            {
+                // adjacent junctions: an empty corridor, recorded from the lower id
+                if (cellRef[cur].junction > j)
+                    corridors.push_back(Corridor{j, cellRef[cur].junction, {}});
+                continue;
+            }
+            if (cellRef[cur].corridor >= 0)
+                continue; // already walked from the other end
+            Corridor cor{j, -1, {}};
+            const int id = (int)corridors.size();
+            int prev = start;
+            while (cellRef[cur].junction < 0)
+            {
+                cor.inner.push_back(cur);
+                cellRef[cur].corridor = id;
+                cellRef[cur].offset = (int)cor.inner.size();
+                int next = -1;
+                for (auto &d2 : dirs)
+                {
+                    const int nr = cur / cols + d2[0], nc = cur % cols + d2[1];
+                    if (passable(nr, nc) && nr * cols + nc != prev)
+                        next = nr * cols + nc;
+                }
+                prev = cur;
+                cur = next;
+            }
+            cor.b = cellRef[cur].junction;
+            corridors.push_back(std::move(cor));
+        }
+    };
+    const int plainJunctions = (int)junctionCell.size();
+    for (int j = 0; j < plainJunctions; ++j)
+        walk(j);
+    // what is left are rings of degree-2 cells: promote one cell of each
+    for (int cell = 0; cell < n; ++cell)
+    {
+        if (grid[cell / cols][cell % cols] == '#' || cellRef[cell].junction >= 0 || cellRef[cell].corridor >= 0)
+            continue;
+        makeJunction(cell);
+        walk((int)junctionCell.size() - 1);
+    }
+}
+
+void ContractionHierarchy::contract(std::vector<std::vector<Edge>> &graph)
+{
+    const int n = (int)graph.size();
+    rank.assign(n, -1);
+    up.assign(n, {});
+    std::vector<int> depth(n, 0);   // hierarchy levels below v, keeps the search spaces shallow
+
+    // witness search state, stamped
+    std::vector<int> wdist(n, INF);
+    std::vector<unsigned> wstamp(n, 0);
+    unsigned wnow = 0;
+    std::vector<Entry> heap; // reused min-heap, see std::push_heap
+    std::vector<unsigned> target(n, 0); // == wnow: a neighbour still to be settled
+    auto witness = [&](int source, int skip, int limit, int settleLimit, int targets) {
+        heap.clear();
+        wstamp[source] = wnow;
+        wdist[source] = 0;
+        heap.push_back({0, source});
+        int settled = 0;
+        while (!heap.empty() && settled < settleLimit)
+        {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+            auto [d, u] = heap.back();
+            heap.pop_back();
+            if (d != wdist[u])
+                continue;
+            if (d > limit)
+                break;
+            ++settled;
+            if (target[u] == wnow && --targets == 0)
+                break;
+            for (const Edge &e : graph[u])
+            {
+                if (e.to == skip || rank[e.to] >= 0)
+                    continue;
+                const int nd = d + e.weight;
+                if (wstamp[e.to] != wnow || nd < wdist[e.to])
+                {
+                    wstamp[e.to] = wnow;
+                    wdist[e.to] = nd;
+                    heap.push_back({nd, e.to});
+                    std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+                }
+            }
+        }
+    };
+    auto witnessDist = [&](int v) { return wstamp[v] == wnow ? wdist[v] : INF; };
+
+    // shortcuts contracting v would add, as (u, w, weight), each pair once
+    std::vector<std::tuple<int, int, int>> needed;
+    auto simulate = [&](int v, int settleLimit) {
+        needed.clear();
+        const auto &adj = graph[v];
+        int maxOut = 0;
+        for (const Edge &e : adj)
+            maxOut = std::max(maxOut, e.weight);
+        for (size_t i = 0; i + 1 < adj.size(); ++i)
+        {
+            const Edge &in = adj[i];
+            ++wnow;
+            for (size_t k = i + 1; k < adj.size(); ++k)
+                target[adj[k].to] = wnow;
+            witness(in.to, v, in.weight + maxOut, settleLimit, (int)(adj.size() - i - 1));
+            for (size_t k = i + 1; k < adj.size(); ++k)
+            {
+                const Edge &out = adj[k];
+                const int via = in.weight + out.weight;
+                if (witnessDist(out.to) > via)
+                    needed.emplace_back(in.to, out.to, via);
+            }
+        }
+    };
+    auto priority = [&](int v) {
+        simulate(v, estimateSettleLimit);
+        return 2 * ((int)needed.size() - (int)graph[v].size()) + depth[v];
+    };
+
+    MinHeap order;
+    for (int v = 0; v < n; ++v)
+        order.push({priority(v), v});
+    int level = 0;
+    while (!order.empty())
+    {
+        const int v = order.top().second;
+        order.pop();
+        if (rank[v] >= 0)
+            continue;
+        // lazy update: re-evaluate and put back if no longer the cheapest
+        const int p = priority(v);
+        if (!order.empty() && p > order.top().first)
+        {
+            order.push({p, v});
+            continue;
+        }
+        simulate(v, witnessSettleLimit);
+        rank[v] = level++;
+        for (const Edge &e : graph[v])
+        {
+            up[v].push_back(e);
+            auto &back = graph[e.to];
+            back.erase(std::remove_if(back.begin(), back.end(), [v](const Edge &x) { return x.to == v; }), back.end());
+            depth[e.to] = std::max(depth[e.to], depth[v] + 1);
+        }
+        for (auto [a, b, w] : needed)
+        {
+            bool found = false;
+            for (Edge &e : graph[a])
+            {
+                if (e.to == b)
+                {
+                    found = true;
+                    if (w < e.weight)
+                    {
+                        e = Edge{b, w, v, -1};
+                        for (Edge &r : graph[b])
+                            if (r.to == a)
+                                r = Edge{a, w, v, -1};
+                    }
+                }
+            }
+            if (!found)
+            {
+                graph[a].push_back(Edge{b, w, v, -1});
+                graph[b].push_back(Edge{a, w, v, -1});
+                ++shortcutCount;
+            }
+        }
+        graph[v].clear();
+        graph[v].shrink_to_fit();
+    }
+}
+
+size_t ContractionHierarchy::memoryBytes() const
+{
+    size_t bytes = cellRef.size() * sizeof(CellRef) + junctionCell.size() * sizeof(int32_t) + rank.size() * sizeof(int32_t);
+    for (const Corridor &c : corridors)
+        bytes += sizeof(Corridor) + c.inner.size() * sizeof(int32_t);
+    for (const auto &edges : up)
+        bytes += sizeof(edges) + edges.size() * sizeof(Edge);
+    return bytes;
+}
+
+int ContractionHierarchy::endpoints(int cell, Endpoint out[2]) const
+{
+    const CellRef &ref = cellRef[cell];
+    if (ref.junction >= 0)
+    {
+        out[0] = {ref.junction, 0};
+        return 1;
+    }
+    if (ref.corridor < 0)
+        return 0; // wall
+    const Corridor &c = corridors[ref.corridor];
+    out[0] = {c.a, ref.offset};
+    out[1] = {c.b, (int)c.inner.size() + 1 - ref.offset};
+    return 2;
+}
+
+int ContractionHierarchy::sameCorridorDistance(int a, int b) const
+{
+    const CellRef &ra = cellRef[a], &rb = cellRef[b];
+    if (ra.corridor < 0 || ra.corridor != rb.corridor)
+        return INF;
+    return std::abs(ra.offset - rb.offset);
+}
+
+ContractionHierarchy::Meeting ContractionHierarchy::search(const Endpoint *src, int nsrc, const Endpoint *dst, int ndst) const
+{
+    SearchSpace &ws = space; // one TLS lookup per query
+    ws.prepare(junctionCell.size());
+    MinHeap heap[2];
+    const Endpoint *seeds[2] = {src, dst};
+    const int counts[2] = {nsrc, ndst};
+    for (int d = 0; d < 2; ++d)
+    {
+        for (int i = 0; i < counts[d]; ++i)
+        {
+            const Endpoint &e = seeds[d][i];
+            if (e.dist < ws.get(d, e.junction))
+            {
+                ws.set(d, e.junction, e.dist, -1, i);
+                heap[d].push({e.dist, e.junction});
+            }
+        }
+    }
+    Meeting best;
+    int bestDist = INF;
+    auto top = [&heap](int d) { return heap[d].empty() ? INF : heap[d].top().first; };
+    while (std::min(top(0), top(1)) < bestDist)
+    {
+        const int d = top(0) <= top(1) ? 0 : 1;
+        auto [du, u] = heap[d].top();
+        heap[d].pop();
+        if (du != ws.get(d, u))
+            continue;
+        const int other = ws.get(1 - d, u);
+        if (other < INF && du + other < bestDist)
+        {
+            bestDist = du + other;
+            best.node = u;
+        }
+        // stall on demand: a higher neighbour already reached more cheaply
+        // proves u is not on a shortest up-down path from this side
+        bool stalled = false;
+        for (const Edge &e : up[u])
+            stalled = stalled || ws.get(d, e.to) + e.weight < du;
+        if (stalled)
+            continue;
+        for (const Edge &e : up[u])
+        {
+            const int nd = du + e.weight;
+            if (nd < ws.get(d, e.to))
+            {
+                ws.set(d, e.to, nd, u, ws.side[d][u]);
+                heap[d].push({nd, e.to});
+            }
+        }
+    }
+    if (best.node < 0)
+        return best;
+    best.dist = bestDist;
+    best.sourceSide = ws.side[0][best.node];
+    best.targetSide = ws.side[1][best.node];
+    return best;
+}
+
+int ContractionHierarchy::passableDistance(int a, int b) const
+{
+    if (a == b)
+        return 0;
+    Endpoint src[2], dst[2];
+    const int ns = endpoints(a, src), nd = endpoints(b, dst);
+    const int direct = sameCorridorDistance(a, b);
+    const Meeting m = search(src, ns, dst, nd);
+    const int viaJunctions = m.dist < 0 ? INF : m.dist;
+    const int d = std::min(direct, viaJunctions);
+    return d >= INF ? -1 : d;
+}
+
+int ContractionHierarchy::distance(Vec2 a, Vec2 b) const
+{
+    const int from = a.x * cols + a.y, to = b.x * cols + b.y;
+    if (from == to)
+        return 0;
+    if (cellRef[to].junction < 0 && cellRef[to].corridor < 0)
+        return -1;
+    if (cellRef[from].junction >= 0 || cellRef[from].corridor >= 0)
+        return passableDistance(from, to);
+    // leaving a wall: the first step enters one of its passable neighbours
+    int best = -1;
+    for (auto &dir : dirs)
+    {
+        const int r = a.x + dir[0], c = a.y + dir[1];
+        if (r < 0 || c < 0 || r >= rows || c >= cols)
+            continue;
+        const int next = r * cols + c;
+        if (cellRef[next].junction < 0 && cellRef[next].corridor < 0)
+            continue;
+        const int d = passableDistance(next, to);
+        if (d >= 0 && (best < 0 || d + 1 < best))
+            best = d + 1;
+    }
+    return best;
+}
+
+const ContractionHierarchy::Edge *ContractionHierarchy::findUp(int lower, int higher) const
+{
+    for (const Edge &e : up[lower])
+        if (e.to == higher)
+            return &e;
+    return nullptr;
+}
+
+void ContractionHierarchy::appendCorridor(int corridor, int from, int to, std::vector<Vec2> &out) const
+{
+    const Corridor &c = corridors[corridor];
+    if (from == c.a)
+        for (int cell : c.inner)
+            out.push_back(cellPos(cell));
+    else
+        for (auto it = c.inner.rbegin(); it != c.inner.rend(); ++it)
+            out.push_back(cellPos(*it));
+    out.push_back(cellPos(junctionCell[to]));
+}
+
+void ContractionHierarchy::unpack(int from, int to, const Edge &e, std::vector<Vec2> &out) const
+{
+    if (e.mid < 0)
+    {
+        appendCorridor(e.corridor, from, to, out);
+        return;
+    }
+    unpack(from, e.mid, *findUp(e.mid, from), out);
+    unpack(e.mid, to, *findUp(e.mid, to), out);
+}
+
+bool ContractionHierarchy::passablePath(int a, int b, std::vector<Vec2> &out) const
+{
+    if (a == b)
+        return true;
+    Endpoint src[2], dst[2];
+    const int ns = endpoints(a, src), nd = endpoints(b, dst);
+    const int direct = sameCorridorDistance(a, b);
+    const Meeting m = search(src, ns, dst, nd);
+    if (direct < INF && (m.dist < 0 || direct <= m.dist))
+    {
+        const Corridor &c = corridors[cellRef[a].corridor];
+        const int oa = cellRef[a].offset, ob = cellRef[b].offset;
+        for (int o = oa; o != ob;)
+        {
+            o += ob > oa ? 1 : -1;
+            out.push_back(cellPos(c.inner[o - 1]));
+        }
+        return true;
+    }
+    if (m.dist < 0)
+        return false;
+
+    // a -> its corridor's end on the source side
+    const CellRef &ra = cellRef[a];
+    if (ra.junction < 0)
+    {
+        const Corridor &c = corridors[ra.corridor];
+        if (m.sourceSide == 0)
+            for (int o = ra.offset - 1; o >= 1; --o)
+                out.push_back(cellPos(c.inner[o - 1]));
+        else
+            for (int o = ra.offset + 1; o <= (int)c.inner.size(); ++o)
+                out.push_back(cellPos(c.inner[o - 1]));
+        out.push_back(cellPos(junctionCell[src[m.sourceSide].junction]));
+    }
+    // up the forward search tree to the meeting node
+    std::vector<int> chain;
+    for (int v = m.node; v >= 0; v = space.parent[0][v])
+        chain.push_back(v);
+    for (size_t i = chain.size() - 1; i > 0; --i)
+        unpack(chain[i], chain[i - 1], *findUp(chain[i], chain[i - 1]), out);
+    // and down the backward search tree
+    for (int v = m.node; space.parent[1][v] >= 0; v = space.parent[1][v])
+    {
+        const int below = space.parent[1][v];
+        unpack(v, below, *findUp(below, v), out);
+    }
+    // the target's corridor end -> b
+    const CellRef &rb = cellRef[b];
+    if (rb.junction < 0)
+    {
+        const Corridor &c = corridors[rb.corridor];
+        if (m.targetSide == 0)
+            for (int o = 1; o <= rb.offset; ++o)
+                out.push_back(cellPos(c.inner[o - 1]));
+        else
+            for (int o = (int)c.inner.size(); o >= rb.offset; --o)
+                out.push_back(cellPos(c.inner[o - 1]));
+    }
+    return true;
+}
+
+bool ContractionHierarchy::appendPath(Vec2 a, Vec2 b, std::vector<Vec2> &out) const
+{
+    const int from = a.x * cols + a.y, to = b.x * cols + b.y;
+    if (from == to)
+        return true;
+    if (cellRef[to].junction < 0 && cellRef[to].corridor < 0)
+        return false;
+    const size_t mark = out.size();
+    if (cellRef[from].junction >= 0 || cellRef[from].corridor >= 0)
+        return passablePath(from, to, out);
+    // leaving a wall: step into the neighbour with the shortest remaining trip
+    int bestNext = -1, best = INF;
+    for (auto &dir : dirs)
+    {
+        const int r = a.x + dir[0], c = a.y + dir[1];
+        if (r < 0 || c < 0 || r >= rows || c >= cols)
+            continue;
+        const int next = r * cols + c;
+        if (cellRef[next].junction < 0 && cellRef[next].corridor < 0)
+            continue;
+        const int d = passableDistance(next, to);
+        if (d >= 0 && d < best)
+        {
+            best = d;
+            bestNext = next;
+        }
+    }
+    if (bestNext < 0)
+        return false;
+    out.push_back(cellPos(bestNext));
+    if (!passablePath(bestNext, to, out))
+    {
+        out.resize(mark);
+        return false;
+    }
+    return true;
+}
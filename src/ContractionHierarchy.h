@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Courier.h" // for Vec2
+
+// Ground distance oracle for large maps (GROUND_ORACLE: CH). Corridors of
+// road cells with exactly two passable neighbours are first collapsed into
+// single weighted edges between junctions (cells of any other degree); the
+// junction graph is then contracted into a hierarchy with shortcuts. A query
+// is a bidirectional upward Dijkstra between the junctions at either end of
+// the two cells' corridors, which settles a few hundred nodes where a BFS
+// would scan the map. Paths are rebuilt by unpacking shortcuts and expanding
+// corridors back into cells.
+//
+// Movement rules match DStarLite: any cell may be left, only non-'#' cells
+// entered. The hierarchy is immutable; a map change needs a rebuild.
+// Queries are thread-safe (per-thread search workspaces).
+class ContractionHierarchy {
+public:
+    explicit ContractionHierarchy(const std::vector<std::string>& grid);
+
+    // Steps from a to b, -1 if b cannot be reached (or is a wall).
+    int distance(Vec2 a, Vec2 b) const;
+    // Appends the cells after a up to and including b. Returns false (leaving
+    // `out` untouched) when b is unreachable.
+    bool appendPath(Vec2 a, Vec2 b, std::vector<Vec2>& out) const;
+
+    // preprocessing statistics, for choosing the oracle per map
+    int cells() const { return passableCells; }
+    int junctions() const { return (int)junctionCell.size(); }
+    int shortcuts() const { return shortcutCount; }
+    double buildMillis() const { return buildMs; }
+    size_t memoryBytes() const;
+
+private:
+    struct Edge {
+        int32_t to;
+        int32_t weight;
+        int32_t mid;      // contracted junction this shortcut bypasses, -1 for a corridor
+        int32_t corridor; // corridor realising an original edge, -1 for shortcuts
+    };
+    struct Corridor {
+        int32_t a, b;                // end junctions (a == b for a loop)
+        std::vector<int32_t> inner;  // interior cells from a's side to b's side
+    };
+    // the place of a cell in the compressed graph
+    struct CellRef {
+        int32_t junction = -1; // junction id, or -1 for corridor cells and walls
+        int32_t corridor = -1;
+        int32_t offset = 0;    // steps from the corridor's `a` end
+    };
+    struct Endpoint {
+        int32_t junction;
+        int32_t dist;
+    };
+
+    int rows, cols;
+    int passableCells = 0;
+    int shortcutCount = 0;
+    double buildMs = 0;
+
+    std::vector<CellRef> cellRef;         // by cell index
+    std::vector<int32_t> junctionCell;    // junction id -> cell index
+    std::vector<Corridor> corridors;
+    std::vector<int32_t> rank;            // contraction order
+    std::vector<std::vector<Edge>> up;    // edges towards higher rank
+
+    void compressCorridors(const std::vector<std::string>& grid);
+    void contract(std::vector<std::vector<Edge>>& graph);
+
+    // endpoints of a cell's corridor (or the junction itself), -1s for walls
+    int endpoints(int cell, Endpoint out[2]) const;
+    // best junction where the two upward searches meet; the per-thread search
+    // trees stay valid for path unpacking until the next search
+    struct Meeting {
+        int dist = -1;
+        int node = -1;
+        int sourceSide = -1; // which source endpoint the forward search left from
+        int targetSide = -1;
+    };
+    Meeting search(const Endpoint* src, int nsrc, const Endpoint* dst, int ndst) const;
+    int sameCorridorDistance(int a, int b) const;
+    void appendCorridor(int corridor, int from, int to, std::vector<Vec2>& out) const;
+    void unpack(int from, int to, const Edge& e, std::vector<Vec2>& out) const;
+    const Edge* findUp(int lower, int higher) const;
+    Vec2 cellPos(int cell) const { return {cell / cols, cell % cols}; }
+    int passableDistance(int a, int b) const;
+    bool passablePath(int a, int b, std::vector<Vec2>& out) const;
+};
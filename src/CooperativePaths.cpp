@@ -0,0 +1,266 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <queue>
+
+// Cooperative ground movement (ROAD_CAPACITY: 1).
+//
+// Each ground courier follows a space-time plan found by A* over (cell, tick)
+// for at most cfg.whcaWindow ticks, with the true ground distance to the
+// target (the goal-rooted planners) as heuristic. Planned slots go into the
+// shared reservation table, so couriers planned later route around them;
+// moving into a held cell, or swapping cells with its holder, is not allowed.
+// A plan only ends on a cell nobody else is due to cross, and the courier
+// stays parked there until it replans. It replans once less than half a
+// window of its plan is left, or when its target changes, so the cost per
+// tick stays linear in the number of couriers. Only road cells have a
+// capacity: base, stations and client doorsteps take any number of couriers.
+// Ground couriers move at most two cells a tick.
+
+static bool samePos(const Vec2 &a, const Vec2 &b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+namespace {
+
+// Insert-only set of non-negative keys in a TickArena (open addressing,
+// linear probing, at most half full); outgrown tables stay in the arena
+// until the tick ends.
+class ArenaSet {
+public:
+    explicit ArenaSet(TickArena &arena) : arena(arena) { rehash(64); }
+
+    bool insert(long long key)
+    {
+        if (2 * (count + 1) > capacity)
+            rehash(2 * capacity);
+        size_t i = slotOf(key);
+        for (; slots[i] >= 0; i = (i + 1) & (capacity - 1))
+            if (slots[i] == key)
+                return false;
+        slots[i] = key;
+        ++count;
+        return true;
+    }
+
+private:
+    TickArena &arena;
+    long long *slots = nullptr;
+    size_t capacity = 0, count = 0;
+
+    size_t slotOf(long long key) const { return (size_t)((uint64_t)key * 0x9E3779B97F4A7C15ull >> 20) & (capacity - 1); }
+    void rehash(size_t newCapacity)
+    {
+        long long *old = slots;
+        const size_t oldCapacity = capacity;
+        slots = arena.allocate<long long>(newCapacity);
+        capacity = newCapacity;
+        std::fill(slots, slots + capacity, -1);
+        for (size_t k = 0; k < oldCapacity; ++k)
+        {
+            if (old[k] < 0)
+                continue;
+            size_t i = slotOf(old[k]);
+            while (slots[i] >= 0)
+                i = (i + 1) & (capacity - 1);
+            slots[i] = old[k];
+        }
+    }
+};
+
+} // namespace
+
+void Simulation::resetCooperativePlans()
+{
+    stPlans.clear();
+    reservations.clear();
+}
+
+void Simulation::cooperativeStep(size_t ci, const Vec2 &target)
+{
+    Courier &c = *couriers[ci];
+    stPlans.resize(couriers.size());
+    SpaceTimePlan &plan = stPlans[ci];
+    const Vec2 cur = c.getPos();
+
+    int k = currentTick - plan.start;
+    bool onPlan = samePos(plan.target, target) && k >= 0 && k < (int)plan.cells.size() &&
+                  samePos(plan.cells[k], cur);
+    if (onPlan && k + 1 < (int)plan.cells.size())
+    {
+        // either cell of the next move may have closed since it was planned
+        const Vec2 next = plan.cells[k + 1];
+        const Vec2 via = plan.via[k + 1];
+        onPlan = map->grid[next.x][next.y] != '#' && (via.x < 0 || map->grid[via.x][via.y] != '#');
+    }
+    const int ahead = onPlan ? (int)plan.cells.size() - 1 - k : 0;
+    if (ahead < std::max(1, cfg.whcaWindow / 2))
+    {
+        planCooperative(ci, target);
+        k = 0;
+    }
+    if (k + 1 < (int)plan.cells.size() && !samePos(plan.cells[k + 1], cur))
+    {
+        const int battery = c.getBattery();
+        c.applyMove(plan.cells[k + 1]);
+        ledger.onTravel(c.kind(), plan.via[k + 1].x >= 0 ? 2 : 1, battery - c.getBattery());
+    }
+}
+
+void Simulation::planCooperative(size_t ci, const Vec2 &target)
+{
+    TraceSpan span("cooperative plan", "courier", (int)ci);
+    Courier &c = *couriers[ci];
+    SpaceTimePlan &plan = stPlans[ci];
+    const int self = (int)ci;
+    const int now = currentTick;
+    const int window = std::max(1, cfg.whcaWindow);
+    const int cols = cfg.cols;
+    const std::vector<std::string> &grid = map->grid;
+    auto cellOf = [cols](const Vec2 &v) { return v.x * cols + v.y; };
+    auto exempt = [&grid](const Vec2 &v) { return grid[v.x][v.y] != '.'; };
+
+    // drop what is left of the previous plan
+    if (!plan.cells.empty())
+        reservations.unpark(cellOf(plan.cells.back()), self);
+    for (size_t k = 0; k < plan.cells.size(); ++k)
+    {
+        const int tick = plan.start + (int)k;
+        if (tick < now)
+            continue;
+        reservations.release(cellOf(plan.cells[k]), tick, self);
+        if (plan.via[k].x >= 0)
+            reservations.release(cellOf(plan.via[k]), tick, self);
+    }
+
+    auto freeAt = [&](const Vec2 &v, int tick) {
+        if (exempt(v))
+            return true;
+        const int h = reservations.holder(cellOf(v), tick);
+        return h == ReservationTable::none || h == self;
+    };
+    // a -> b during tick -> tick + 1 must not swap places with b's holder
+    auto noSwap = [&](const Vec2 &a, const Vec2 &b, int tick) {
+        if (exempt(a) || exempt(b))
+            return true;
+        const int other = reservations.holder(cellOf(b), tick);
+        return other == ReservationTable::none || other == self ||
+               reservations.holder(cellOf(a), tick + 1) != other;
+    };
+    // a plan may end at (v, tick) only if v stays free for as long as any
+    // current plan reaches, since the courier then parks there
+    auto canPark = [&](const Vec2 &v, int tick) {
+        for (int t = tick + 1; t <= now + window + 1; ++t)
+            if (!freeAt(v, t))
+                return false;
+        return true;
+    };
+    const int speed = std::max(1, std::min(2, c.getSpeed()));
+    auto heuristic = [&](const Vec2 &v) {
+        const int d = computeDistance(v, target, false);
+        return d < 0 ? -1 : (d + speed - 1) / speed;
+    };
+
+    struct Node {
+        Vec2 pos;
+        Vec2 via;
+        int dt;
+        int h;
+        int parent;
+    };
+    // the search lives in the tick arena
+    ArenaVector<Node> nodes{ArenaAllocator<Node>(arena)};
+    ArenaSet seen(arena);
+    using Entry = std::pair<int, int>; // (f, then later ticks first; node)
+    std::priority_queue<Entry, ArenaVector<Entry>, std::greater<Entry>> open{std::greater<Entry>(),
+                                                                             ArenaVector<Entry>(ArenaAllocator<Entry>(arena))};
+    auto push = [&](const Vec2 &pos, const Vec2 &via, int dt, int parent) {
+        if (!seen.insert((long long)cellOf(pos) * (window + 1) + dt))
+            return;
+        const int h = heuristic(pos);
+        if (h < 0)
+            return;
+        nodes.push_back({pos, via, dt, h, parent});
+        open.push({(dt + h) * (window + 1) + (window - dt), (int)nodes.size() - 1});
+    };
+
+    const Vec2 none{-1, -1};
+    const Vec2 cur = c.getPos();
+    push(cur, none, 0, -1);
+    int goal = -1;
+    int best = nodes.empty() ? -1 : 0; // parkable, closest to the target, then furthest in time
+    static const int dr[4] = {1, -1, 0, 0};
+    static const int dc[4] = {0, 0, 1, -1};
+    auto enterable = [&](int x, int y) { return x >= 0 && x < cfg.rows && y >= 0 && y < cols && grid[x][y] != '#'; };
+    while (!open.empty())
+    {
+        const int idx = open.top().second;
+        open.pop();
+        const Node n = nodes[idx];
+        const int tick = now + n.dt;
+        const bool parkable = canPark(n.pos, tick);
+        if (parkable && (n.h < nodes[best].h || (n.h == nodes[best].h && n.dt > nodes[best].dt)))
+            best = idx;
+        if ((n.h == 0 || n.dt == window) && parkable)
+        {
+            goal = idx;
+            break;
+        }
+        if (n.dt == window)
+            continue;
+        if (freeAt(n.pos, tick + 1))
+            push(n.pos, none, n.dt + 1, idx); // wait
+        for (int a = 0; a < 4; ++a)
+        {
+            const Vec2 m{n.pos.x + dr[a], n.pos.y + dc[a]};
+            if (!enterable(m.x, m.y) || !freeAt(m, tick + 1) || !noSwap(n.pos, m, tick))
+                continue;
+            push(m, none, n.dt + 1, idx);
+            if (speed < 2)
+                continue;
+            for (int b = 0; b < 4; ++b)
+            {
+                const Vec2 v{m.x + dr[b], m.y + dc[b]};
+                if (samePos(v, n.pos) || !enterable(v.x, v.y) || !freeAt(v, tick + 1) || !noSwap(m, v, tick))
+                    continue;
+                push(v, m, n.dt + 1, idx);
+            }
+        }
+    }
+    if (goal < 0)
+        goal = best;
+
+    plan.target = target;
+    plan.start = now;
+    plan.cells.clear();
+    plan.via.clear();
+    for (int i = goal; i >= 0; i = nodes[i].parent)
+    {
+        plan.cells.push_back(nodes[i].pos);
+        plan.via.push_back(nodes[i].via);
+    }
+    if (plan.cells.empty())
+    {
+        plan.cells.push_back(cur);
+        plan.via.push_back(none);
+    }
+    std::reverse(plan.cells.begin(), plan.cells.end());
+    std::reverse(plan.via.begin(), plan.via.end());
+
+    for (size_t k = 0; k < plan.cells.size(); ++k)
+    {
+        const int tick = now + (int)k;
+        bool ok = exempt(plan.cells[k]) || reservations.reserve(cellOf(plan.cells[k]), tick, self);
+        if (plan.via[k].x >= 0 && !exempt(plan.via[k]))
+            ok = reservations.reserve(cellOf(plan.via[k]), tick, self) && ok;
+        if (!ok && k > 0)
+            ++reservationConflicts; // boxed in: share the cell rather than stall the run
+    }
+    const Vec2 last = plan.cells.back();
+    if (!exempt(last) && !reservations.park(cellOf(last), now + (int)plan.cells.size(), self))
+        ++reservationConflicts;
+    // nowhere to go, not even to stay: the courier keeps its cell regardless
+    if (plan.cells.size() == 1 && !freeAt(cur, now + 1))
+        ++reservationConflicts;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Independent random streams of one run. A stream's numbers depend only on
+// its key, never on how many numbers other streams drew before it.
+enum class RngStream : uint8_t {
+    MapGeneration = 1, // entity: generation attempt
+    PackageSpawn = 2,  // tick: spawn tick, entity: package id
+    LookaheadSpawn = 3 // like PackageSpawn, for the futures lookahead rollouts imagine
+};
+
+// Counter-based generator (Philox4x32-10, Salmon et al., SC'11): the n-th
+// number of a stream is a pure function of (seed, stream, replica, tick,
+// entity, n). Streams are cheap to create, so callers key one per entity
+// instead of sharing a generator, which keeps results identical whatever the
+// thread count or call order. discard() jumps ahead in O(1). Satisfies
+// UniformRandomBitGenerator; a stream holds 2^34 numbers.
+class CounterRng {
+public:
+    using result_type = uint32_t;
+    using Block = std::array<uint32_t, 4>;
+
+    CounterRng(uint64_t seed, RngStream stream, uint32_t replica = 0, uint32_t tick = 0, uint32_t entity = 0)
+        : key{(uint32_t)seed, (uint32_t)(seed >> 32)},
+          ctr{0, entity, tick, (uint32_t)stream << 24 | (replica & 0xffffffu)}
+    {
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()()
+    {
+        if ((pos & 3) == 0)
+            refill();
+        return block[pos++ & 3];
+    }
+
+    void discard(uint64_t n)
+    {
+        pos += n;
+        if (pos & 3)
+            refill();
+    }
+    uint64_t position() const { return pos; } // numbers drawn so far
+
+    // the raw bijection: 10 rounds over a 128-bit counter under a 64-bit key
+    static Block philox(Block c, std::array<uint32_t, 2> k)
+    {
+        for (int round = 0; round < 10; ++round)
+        {
+            if (round > 0)
+            {
+                k[0] += 0x9E3779B9u;
+                k[1] += 0xBB67AE85u;
+            }
+            const uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+            const uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+            c = {(uint32_t)(p1 >> 32) ^ c[1] ^ k[0], (uint32_t)p1, (uint32_t)(p0 >> 32) ^ c[3] ^ k[1], (uint32_t)p0};
+        }
+        return c;
+    }
+
+private:
+    void refill()
+    {
+        ctr[0] = (uint32_t)(pos >> 2);
+        block = philox(ctr, key);
+    }
+
+    std::array<uint32_t, 2> key;
+    Block ctr;
+    Block block{};
+    uint64_t pos = 0;
+};
@@ -68,6 +68,17 @@ bool Courier::isDead() const {
     return dead;
 }
 
+void Courier::restoreState(const Vec2& newPos, int newSpeed, int newBattery, bool isDeadNow) {
+    pos = newPos;
+    speed = newSpeed;
+    battery = newBattery;
+    dead = isDeadNow;
+}
+
+void Courier::rebindPackages(const std::vector<Package*>& newPackages) {
+    packages = newPackages;
+}
+
 // ---------------- Drone ----------------
 
 Drone::Drone(Vec2 startPos)
@@ -85,6 +96,8 @@ Drone::Drone(Vec2 startPos)
 
 bool Drone::canFly() const { return true; }
 std::string Drone::typeName() const { return "Drone"; }
+CourierKind Drone::kind() const { return CourierKind::Drone; }
+std::unique_ptr<Courier> Drone::clone() const { return std::make_unique<Drone>(*this); }
 
 // Vec2 Drone::computeNextMove() {
 //     // TODO: implement proper movement
@@ -107,6 +120,8 @@ Robot::Robot(Vec2 startPos)
 
 bool Robot::canFly() const { return false; }
 std::string Robot::typeName() const { return "Robot"; }
+CourierKind Robot::kind() const { return CourierKind::Robot; }
+std::unique_ptr<Courier> Robot::clone() const { return std::make_unique<Robot>(*this); }
 
 // Vec2 Robot::computeNextMove() {
 //     // TODO: implement proper movement
@@ -129,6 +144,8 @@ Scooter::Scooter(Vec2 startPos)
 
 bool Scooter::canFly() const { return false; }
 std::string Scooter::typeName() const { return "Scooter"; }
+CourierKind Scooter::kind() const { return CourierKind::Scooter; }
+std::unique_ptr<Courier> Scooter::clone() const { return std::make_unique<Scooter>(*this); }
 
 // Vec2 Scooter::computeNextMove() {
 //     // TODO: implement proper movement
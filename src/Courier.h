@@ -1,11 +1,15 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include "Package.h"
 struct Vec2 {
     int x, y;
 };
 
+// Cheap type tag for hot paths that would otherwise compare typeName() strings
+enum class CourierKind { Drone = 0, Robot = 1, Scooter = 2 };
+
 class Courier {
 public:
     Courier(Vec2 startPos,
@@ -19,6 +23,10 @@ public:
 
     virtual bool canFly() const = 0;
     virtual std::string typeName() const = 0;
+    virtual CourierKind kind() const = 0;
+    // Copy of this courier including its package pointers; callers that copy
+    // into another Simulation must re-point packages (see rebindPackages).
+    virtual std::unique_ptr<Courier> clone() const = 0;
 
     // virtual Vec2 computeNextMove() = 0;
 
@@ -33,6 +41,10 @@ public:
     void recharge(int amount);
     void kill();
     bool isDead() const;
+
+    // Snapshot/fork support: overwrite mutable state and package pointers
+    void restoreState(const Vec2& newPos, int newSpeed, int newBattery, bool isDeadNow);
+    void rebindPackages(const std::vector<Package*>& newPackages);
     // --- Getters ---
     Vec2 getPos() const;
     int getSpeed() const;
@@ -66,6 +78,8 @@ public:
 
     bool canFly() const override;
     std::string typeName() const override;
+    CourierKind kind() const override;
+    std::unique_ptr<Courier> clone() const override;
     // Vec2 computeNextMove() override;
 };
 
@@ -75,6 +89,8 @@ public:
 
     bool canFly() const override;
     std::string typeName() const override;
+    CourierKind kind() const override;
+    std::unique_ptr<Courier> clone() const override;
     // Vec2 computeNextMove() override;
 };
 
@@ -84,5 +100,7 @@ public:
 
     bool canFly() const override;
     std::string typeName() const override;
+    CourierKind kind() const override;
+    std::unique_ptr<Courier> clone() const override;
     // Vec2 computeNextMove() override;
 };
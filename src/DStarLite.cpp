@@ -0,0 +1,132 @@
+#include "DStarLite.h"
+
+#include <algorithm>
+
+static const int dr[4] = {1, -1, 0, 0};
+static const int dc[4] = {0, 0, 1, -1};
+
+DStarLite::DStarLite(int rows, int cols, Vec2 goal)
+    : rows(rows), cols(cols), goal(goal), goalIdx(goal.x * cols + goal.y),
+      g(rows * cols, INF), rhs(rows * cols, INF)
+{
+    rhs[goalIdx] = 0;
+    open.push({0, goalIdx});
+}
+
+void DStarLite::updateVertex(const std::vector<std::string> &grid, int idx)
+{
+    if (idx != goalIdx)
+    {
+        // best successor: a neighbour we are allowed to enter
+        int best = INF;
+        int r = idx / cols, c = idx % cols;
+        for (int k = 0; k < 4; ++k)
+        {
+            int nr = r + dr[k], nc = c + dc[k];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            int n = nr * cols + nc;
+            if (!passable(grid, n) || g[n] >= INF)
+                continue;
+            best = std::min(best, g[n] + 1);
+        }
+        rhs[idx] = best;
+    }
+    if (g[idx] != rhs[idx])
+        open.push({key(idx), idx});
+}
+
+void DStarLite::computeShortestPath(const std::vector<std::string> &grid, int startIdx)
+{
+    while (!open.empty())
+    {
+        Entry top = open.top();
+        int u = top.second;
+        if (g[u] == rhs[u] || top.first != key(u))
+        {
+            open.pop(); // stale entry
+            continue;
+        }
+        if (top.first >= key(startIdx) && g[startIdx] == rhs[startIdx])
+            break;
+        open.pop();
+
+        if (g[u] > rhs[u])
+            g[u] = rhs[u];
+        else
+        {
+            g[u] = INF;
+            updateVertex(grid, u);
+        }
+        // predecessors of u are its neighbours, but only if u can be entered
+        if (!passable(grid, u))
+            continue;
+        int r = u / cols, c = u % cols;
+        for (int k = 0; k < 4; ++k)
+        {
+            int nr = r + dr[k], nc = c + dc[k];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            updateVertex(grid, nr * cols + nc);
+        }
+    }
+}
+
+int DStarLite::distanceFrom(const std::vector<std::string> &grid, Vec2 start)
+{
+    int s = start.x * cols + start.y;
+    if (s == goalIdx)
+        return 0;
+    computeShortestPath(grid, s);
+    return g[s] >= INF ? -1 : g[s];
+}
+
+bool DStarLite::appendPath(const std::vector<std::string> &grid, Vec2 start, std::vector<Vec2> &out)
+{
+    if (distanceFrom(grid, start) < 0)
+        return false;
+    size_t first = out.size();
+    int cur = start.x * cols + start.y;
+    while (cur != goalIdx)
+    {
+        // every neighbour one step closer is settled once the start is, so
+        // following the gradient yields a shortest path
+        int r = cur / cols, c = cur % cols;
+        int next = -1;
+        for (int k = 0; k < 4 && next < 0; ++k)
+        {
+            int nr = r + dr[k], nc = c + dc[k];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+                continue;
+            int n = nr * cols + nc;
+            if (passable(grid, n) && g[n] == g[cur] - 1)
+                next = n;
+        }
+        if (next < 0)
+        {
+            out.resize(first);
+            return false;
+        }
+        out.push_back({next / cols, next % cols});
+        cur = next;
+    }
+    return true;
+}
+
+void DStarLite::cellChanged(const std::vector<std::string> &grid, Vec2 cell)
+{
+    int idx = cell.x * cols + cell.y;
+    updateVertex(grid, idx);
+    for (int k = 0; k < 4; ++k)
+    {
+        int nr = cell.x + dr[k], nc = cell.y + dc[k];
+        if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+            continue;
+        updateVertex(grid, nr * cols + nc);
+    }
+}
+
+size_t DStarLite::memoryBytes() const
+{
+    return (g.capacity() + rhs.capacity()) * sizeof(int) + open.size() * sizeof(Entry);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <queue>
+#include <functional>
+#include <utility>
+#include "Courier.h" // for Vec2
+
+// Incremental ground search rooted at a fixed goal (D* Lite / LPA* run
+// backwards from the goal). The heuristic is zero, so a single instance serves
+// every courier heading to the same goal regardless of where it starts. The
+// search is lazy: a query only expands cells until its start is settled, and
+// a cell switching between wall and road only re-queues that cell and its
+// neighbours; the next query repairs just the affected region.
+//
+// Movement rules match the BFS used elsewhere: any cell may be left, only
+// non-'#' cells may be entered.
+class DStarLite {
+public:
+    DStarLite(int rows, int cols, Vec2 goal);
+
+    Vec2 getGoal() const { return goal; }
+
+    // Shortest ground distance from start to the goal, -1 if unreachable.
+    int distanceFrom(const std::vector<std::string>& grid, Vec2 start);
+    // Append the cells after `start` up to and including the goal. Returns
+    // false (leaving `out` untouched) when the goal is unreachable.
+    bool appendPath(const std::vector<std::string>& grid, Vec2 start, std::vector<Vec2>& out);
+    // Call after grid[cell] switched between '#' and a passable cell.
+    void cellChanged(const std::vector<std::string>& grid, Vec2 cell);
+
+    size_t memoryBytes() const;
+
+private:
+    static constexpr int INF = 1 << 29;
+    using Entry = std::pair<int, int>; // (key, cell index)
+
+    bool passable(const std::vector<std::string>& grid, int idx) const
+    {
+        return grid[idx / cols][idx % cols] != '#';
+    }
+    int key(int idx) const { return std::min(g[idx], rhs[idx]); }
+    void updateVertex(const std::vector<std::string>& grid, int idx);
+    void computeShortestPath(const std::vector<std::string>& grid, int startIdx);
+
+    int rows, cols;
+    Vec2 goal;
+    int goalIdx;
+    std::vector<int> g;   // settled distance to goal
+    std::vector<int> rhs; // one-step lookahead distance to goal
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open; // lazy deletion
+};
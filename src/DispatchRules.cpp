@@ -0,0 +1,124 @@
+#include "DispatchRules.h"
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+bool RuleTable::parse(std::istream &in)
+{
+    std::string type, field, value;
+    if (!(in >> type >> field >> value))
+        return false;
+
+    CourierKind kind;
+    if (type == "DRONE")
+        kind = CourierKind::Drone;
+    else if (type == "ROBOT")
+        kind = CourierKind::Robot;
+    else if (type == "SCOOTER")
+        kind = CourierKind::Scooter;
+    else
+        return false;
+
+    auto toInt = [](const std::string &s, int &out) {
+        char *end = nullptr;
+        long v = std::strtol(s.c_str(), &end, 10);
+        if (s.empty() || *end != '\0' || v < 0)
+            return false;
+        out = (int)v;
+        return true;
+    };
+
+    CourierRule rule = rules[(int)kind];
+    if (field == "MIN_REWARD")
+    {
+        if (value == "OFF")
+            rule.minReward = -1;
+        else if (!toInt(value, rule.minReward))
+            return false;
+    }
+    else if (field == "MAX_DISTANCE")
+    {
+        rule.maxDistance = -1;
+        rule.maxDistanceRowsDiv = 0;
+        if (value.rfind("ROWS/", 0) == 0)
+        {
+            if (!toInt(value.substr(5), rule.maxDistanceRowsDiv) || rule.maxDistanceRowsDiv == 0)
+                return false;
+        }
+        else if (value != "OFF" && !toInt(value, rule.maxDistance))
+            return false;
+    }
+    else if (field == "BATTERY_RESERVE")
+    {
+        if (!toInt(value, rule.batteryReservePct) || rule.batteryReservePct > 100)
+            return false;
+    }
+    else
+        return false;
+
+    rules[(int)kind] = rule;
+    return true;
+}
+
+// One instantiation per courier type and set of enabled rules, so disabled
+// rules cost nothing and the flying/ground split is resolved at compile
+// time. This is the half of the pair cost that needs lookups - the rules,
+// the nearest-charger field and the planner; the arithmetic half is
+// scoreBatch, run over a whole row of slots at once. Checks that need no
+// path query run first: the Manhattan distance is a lower bound on both air
+// and ground distance, so range and a battery bound can reject before the
+// planner is consulted.
+template <CourierKind K, bool MinReward, bool MaxDistance>
+Simulation::PairInputs Simulation::pairInputs(const Simulation &sim, const Courier &c, const Package &p,
+                                              const CompiledRule &rule, int reach)
+{
+    constexpr bool flies = K == CourierKind::Drone;
+    PairInputs in;
+
+    if (MinReward && p.getReward() < rule.minReward)
+        return in;
+
+    const Vec2 from = c.getPos();
+    const Vec2 dest{p.getDestX(), p.getDestY()};
+    // after delivering, the courier must still reach a charger
+    const int after = sim.chargers->distance(dest, flies);
+    if (after < 0)
+        return in;
+    in.after = after;
+    in.outBound = std::abs(from.x - dest.x) + std::abs(from.y - dest.y);
+    if (MaxDistance && in.outBound > rule.maxDistance)
+        return in;
+    if (in.outBound + after > reach)
+        return in; // not even a full battery would do (scoreBatch checks the exact need)
+
+    const int dist = flies ? in.outBound : sim.computeDistance(from, dest, false);
+    if (dist < 0 || (MaxDistance && dist > rule.maxDistance))
+        return in;
+    in.dist = dist;
+    return in;
+}
+
+void Simulation::compileRules()
+{
+    auto pick = [](auto kindTag, const CourierRule &r) -> PairInputsFn {
+        constexpr CourierKind K = decltype(kindTag)::value;
+        if (r.hasMinReward())
+            return r.hasMaxDistance() ? &pairInputs<K, true, true> : &pairInputs<K, true, false>;
+        return r.hasMaxDistance() ? &pairInputs<K, false, true> : &pairInputs<K, false, false>;
+    };
+
+    for (int k = 0; k < 3; ++k)
+    {
+        const CourierRule &r = cfg.rules.rules[k];
+        CompiledRule &out = compiledRules[k];
+        out.minReward = r.minReward;
+        out.maxDistance = r.resolvedMaxDistance(cfg.rows);
+        out.batteryReservePct = r.batteryReservePct;
+    }
+    compiledRules[0].inputs = pick(std::integral_constant<CourierKind, CourierKind::Drone>{}, cfg.rules.rules[0]);
+    compiledRules[1].inputs = pick(std::integral_constant<CourierKind, CourierKind::Robot>{}, cfg.rules.rules[1]);
+    compiledRules[2].inputs = pick(std::integral_constant<CourierKind, CourierKind::Scooter>{}, cfg.rules.rules[2]);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <istream>
+#include "Courier.h" // for CourierKind
+
+// Per-courier-type dispatch feasibility rules, set in the config as
+//   RULE: <DRONE|ROBOT|SCOOTER> <FIELD> <value>
+// with FIELD one of MIN_REWARD, MAX_DISTANCE (a path length, or ROWS/<n>)
+// and BATTERY_RESERVE (percent of max battery kept unused on the round
+// trip). OFF disables MIN_REWARD and MAX_DISTANCE. The Simulation compiles
+// the table once into one specialised predicate per courier type.
+struct CourierRule {
+    int minReward = -1;         // reject packages paying less (-1 = off)
+    int maxDistance = -1;       // reject destinations farther away (-1 = off)
+    int maxDistanceRowsDiv = 0; // if > 0, maxDistance is rows / this
+    int batteryReservePct = 0;
+
+    bool hasMinReward() const { return minReward >= 0; }
+    bool hasMaxDistance() const { return maxDistance >= 0 || maxDistanceRowsDiv > 0; }
+    int resolvedMaxDistance(int rows) const { return maxDistanceRowsDiv > 0 ? rows / maxDistanceRowsDiv : maxDistance; }
+};
+
+struct RuleTable {
+    CourierRule rules[3]; // indexed by CourierKind
+
+    // defaults reproduce the original hard-coded heuristics
+    RuleTable()
+    {
+        rules[(int)CourierKind::Drone].minReward = 300;
+        rules[(int)CourierKind::Robot].maxDistanceRowsDiv = 3;
+    }
+
+    CourierRule& operator[](CourierKind k) { return rules[(int)k]; }
+    const CourierRule& operator[](CourierKind k) const { return rules[(int)k]; }
+
+    // Parses what follows "RULE:" on a config line. Returns false (leaving the
+    // table untouched) on an unknown courier type, field or value.
+    bool parse(std::istream& in);
+};
@@ -0,0 +1,214 @@
+#include "DispatchService.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Errors.h"
+#include "Simulation.h"
+
+DispatchService::DispatchService(Simulation &sim, const std::string &socketPath, int tickMs)
+    : sim(sim), path(socketPath), tickMs(std::max(1, tickMs))
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path))
+        throw ServiceError("socket path too long: " + path);
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+        throw ServiceError(std::string("socket: ") + std::strerror(errno));
+    unlink(path.c_str()); // a stale socket from a previous run
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 64) != 0)
+    {
+        std::string why = std::strerror(errno);
+        close(listenFd);
+        throw ServiceError("cannot listen on " + path + ": " + why);
+    }
+}
+
+DispatchService::~DispatchService()
+{
+    for (auto &c : clients)
+        close(c.fd);
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+void DispatchService::stop()
+{
+    stopping.store(true);
+}
+
+void DispatchService::run()
+{
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::milliseconds(tickMs);
+    auto next = clock::now() + period;
+    std::vector<pollfd> fds;
+    while (!stopping.load())
+    {
+        fds.clear();
+        fds.push_back({listenFd, POLLIN, 0});
+        for (const auto &c : clients)
+            fds.push_back({c.fd, POLLIN, 0});
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - clock::now()).count();
+        // wake up periodically so stop() from another thread is noticed
+        int ready = poll(fds.data(), fds.size(), (int)std::clamp<long long>(wait, 0, 50));
+        if (ready > 0)
+        {
+            if (fds[0].revents & POLLIN)
+                acceptClients();
+            // fds[i + 1] belongs to clients[i]; new clients were appended after it
+            std::vector<Client> kept;
+            kept.reserve(clients.size());
+            for (size_t i = 0; i < clients.size(); ++i)
+            {
+                bool keep = true;
+                if (i + 1 < fds.size() && fds[i + 1].revents)
+                    keep = serviceClient(clients[i]);
+                if (keep)
+                    kept.push_back(std::move(clients[i]));
+                else
+                    close(clients[i].fd);
+            }
+            clients.swap(kept);
+        }
+        const auto now = clock::now();
+        if (now >= next)
+        {
+            const int due = 1 + (int)((now - next) / period);
+            next += period * tick(due);
+            if (now - next > period)
+            {
+                // too far behind to catch up: skip the backlog instead of bursting
+                ++late;
+                next = now + period;
+            }
+        }
+    }
+}
+
+void DispatchService::acceptClients()
+{
+    for (;;)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        clients.push_back({fd, {}});
+    }
+}
+
+bool DispatchService::serviceClient(Client &c)
+{
+    char buf[4096];
+    for (;;)
+    {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n == 0)
+            return false;
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        c.in.append(buf, n);
+    }
+    std::string out;
+    size_t start = 0, eol;
+    while ((eol = c.in.find('\n', start)) != std::string::npos)
+    {
+        std::string line = c.in.substr(start, eol - start);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        out += handle(line);
+        out += '\n';
+        start = eol + 1;
+    }
+    c.in.erase(0, start);
+    if (c.in.size() > 4096)
+        return false; // no sane request is this long
+
+    size_t sent = 0;
+    while (sent < out.size())
+    {
+        ssize_t n = send(c.fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n <= 0)
+            return false; // the client is not reading its replies
+        sent += n;
+    }
+    return true;
+}
+
+std::string DispatchService::handle(const std::string &line)
+{
+    std::istringstream iss(line);
+    std::string cmd;
+    iss >> cmd;
+    std::ostringstream out;
+    if (cmd == "SUBMIT")
+    {
+        OrderRequest o;
+        if (!(iss >> o.destX >> o.destY >> o.reward >> o.deadlineTicks))
+            return "ERR usage: SUBMIT <x> <y> <reward> <deadlineTicks>";
+        o.submittedUs = orderClockUs();
+        return sim.orderQueue().tryPush(o) ? "QUEUED" : "REJECTED queue full";
+    }
+    if (cmd == "STATUS")
+    {
+        const KpiLedger &k = sim.getLedger();
+        const OrderQueue &q = sim.orderQueue();
+        out << "STATUS tick=" << sim.getCurrentTick() << " waiting=" << sim.packagePool.size()
+            << " assigned=" << k.assigned << " delivered=" << k.delivered << " late=" << k.deliveredLate
+            << " active=" << k.activeCouriers << " queue=" << q.depth() << "/" << q.capacity()
+            << " hw=" << q.highWater() << " rejected=" << q.rejected() << " invalid=" << sim.invalidOrders
+            << " lateTicks=" << late;
+        return out.str();
+    }
+    if (cmd == "LATENCY")
+    {
+        const LatencyHistogram &h = sim.getAssignLatency();
+        out << "LATENCY count=" << h.count() << " p50=" << h.percentile(0.5) << " p90=" << h.percentile(0.9)
+            << " p99=" << h.percentile(0.99) << " max=" << h.max();
+        return out.str();
+    }
+    if (cmd == "CLIENTS")
+    {
+        const auto &cl = sim.map->clients;
+        out << "CLIENTS " << cl.size();
+        for (const auto &v : cl)
+            out << ' ' << v.x << ' ' << v.y;
+        return out.str();
+    }
+    if (cmd == "SHUTDOWN")
+    {
+        stop();
+        return "BYE";
+    }
+    return "ERR unknown command '" + cmd + "'";
+}
+
+int DispatchService::tick(int due)
+{
+    // one simulated tick per period; through advance() so allocation stats
+    // and trace export requests work as in a batch run, and the event engine
+    // may jump over idle ticks as long as they are already due on the clock
+    const int advanced = sim.advance(due);
+    sim.publishState();
+    const Config &cfg = sim.cfg;
+    if (!cfg.snapshotFile.empty() && cfg.snapshotInterval > 0 && sim.currentTick % cfg.snapshotInterval == 0)
+        sim.saveSnapshot(cfg.snapshotFile);
+    return advanced;
+}
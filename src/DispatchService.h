@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class Simulation;
+
+// Long-running dispatch daemon (SERVICE_SOCKET:). Keeps the simulation alive,
+// ticks it every tickMs of wall-clock time (with ENGINE: EVENT, idle ticks
+// the service has fallen behind on are covered in one jump) and serves a line protocol on a
+// Unix stream socket, one request per line, one reply line each:
+//
+//   SUBMIT <x> <y> <reward> <deadlineTicks>  -> QUEUED | REJECTED queue full | ERR ...
+//   STATUS                                   -> STATUS tick=.. waiting=.. ...
+//   LATENCY                                  -> LATENCY count=.. p50=.. p90=.. p99=.. max=.. (us)
+//   CLIENTS                                  -> CLIENTS <n> <x> <y> ...
+//   SHUTDOWN                                 -> BYE, then the service stops
+//
+// Submissions go through the simulation's order queue, so a full queue is
+// reported to the client rather than buffered. Latency runs from the moment a
+// SUBMIT line is read to the dispatch round that assigns the package. Socket
+// I/O and ticking share the simulation thread (poll() waits until the next
+// tick is due), so queries always see a consistent state. MAX_TICKS does not
+// apply in service mode; clients that do not read their replies are dropped.
+class DispatchService {
+public:
+    DispatchService(Simulation& sim, const std::string& socketPath, int tickMs);
+    ~DispatchService();
+
+    DispatchService(const DispatchService&) = delete;
+    DispatchService& operator=(const DispatchService&) = delete;
+
+    void run();  // until SHUTDOWN or stop()
+    void stop(); // may be called from any thread
+
+    int lateTicks() const { return late; } // ticks started more than a period behind schedule
+
+private:
+    struct Client {
+        int fd;
+        std::string in;
+    };
+
+    Simulation& sim;
+    std::string path;
+    int tickMs;
+    int listenFd = -1;
+    std::vector<Client> clients;
+    std::atomic<bool> stopping{false};
+    int late = 0;
+
+    void acceptClients();
+    bool serviceClient(Client& c); // false once the client should be dropped
+    std::string handle(const std::string& line);
+    int tick(int due); // advances up to `due` ticks, returns how many
+};
@@ -10,4 +10,20 @@ public:
 class MapGenerationError : public std::runtime_error {
 public:
     explicit MapGenerationError(const std::string &msg) : std::runtime_error(msg) {}
-};
\ No newline at end of file
+};
+
+class SnapshotError : public std::runtime_error {
+public:
+    explicit SnapshotError(const std::string &msg) : std::runtime_error(msg) {}
+};
+
+// telemetry could not be written mid-run (disk full, file gone)
+class TelemetryError : public std::runtime_error {
+public:
+    explicit TelemetryError(const std::string &msg) : std::runtime_error(msg) {}
+};
+
+class ServiceError : public std::runtime_error {
+public:
+    explicit ServiceError(const std::string &msg) : std::runtime_error(msg) {}
+};
@@ -0,0 +1,121 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Discrete-event advance (ENGINE: EVENT).
+//
+// A tick can only change decisions when a package spawns or a package is
+// waiting or carried. In between, couriers just head home and recharge, which
+// is deterministic, so the engine jumps straight to the next event: a spawn
+// tick, a telemetry sample, a snapshot or the end of the horizon. Couriers
+// still travelling follow their cached routes through the same per-courier
+// update as the tick engine until they reach the base; from then on the
+// recharge and operating cost of the remaining ticks are applied in closed
+// form. Arrivals need no event of their own because nothing reacts to them.
+// Both engines therefore produce identical runs.
+
+static bool atBase(const Courier &c, const Vec2 &base)
+{
+    return c.getPos().x == base.x && c.getPos().y == base.y;
+}
+
+// smallest multiple of `every` that is >= from
+static int nextMultiple(int from, int every)
+{
+    return (from + every - 1) / every * every;
+}
+
+int Simulation::idleTicksAvailable() const
+{
+    if (!packagePool.empty() || (orders && orders->depth() > 0))
+        return 0;
+    for (const auto &c : couriers)
+    {
+        if (c->isDead())
+            continue;
+        if (!c->getPackages().empty())
+            return 0; // delivering, or recharging before a delivery
+        if (atBase(*c, map->basePos))
+            continue;
+        if (cfg.roadCapacity > 0 && !c->canFly())
+            return 0; // cooperative moves depend on the tick-by-tick reservations
+        // on its way home: it must make it without a charging detour, which
+        // then holds for the whole trip (the battery needed falls by exactly
+        // one tick's consumption per tick travelled)
+        const int trip = computeDistance(c->getPos(), map->basePos, c->canFly());
+        if (trip < 0)
+            return 0;
+        const int need = (trip + c->getSpeed() - 1) / c->getSpeed() * c->getConsumption();
+        if (c->getBattery() < need)
+            return 0;
+    }
+
+    int until = cfg.maxTicks;
+    if (cfg.spawnFrequency > 0 && spawnedPackages < cfg.totalPackages)
+        until = std::min(until, nextMultiple(currentTick, cfg.spawnFrequency));
+    // samples and snapshots are taken after a tick ends, i.e. at tick + 1
+    if (telemetry)
+        until = std::min(until, nextMultiple(currentTick + 1, std::max(1, cfg.telemetryInterval)));
+    if (!cfg.snapshotFile.empty() && cfg.snapshotInterval > 0)
+        until = std::min(until, nextMultiple(currentTick + 1, cfg.snapshotInterval));
+    return std::max(0, until - currentTick);
+}
+
+void Simulation::fastForward(int ticks)
+{
+    arena.reset();
+    TraceSpan span("fast-forward", "ticks", ticks);
+    AllocCounts allocMark = AllocTracker::thisThread();
+    auto start = std::chrono::steady_clock::now();
+    routes.resize(couriers.size());
+    const char baseCell = map->grid[map->basePos.x][map->basePos.y];
+    const int rechargesAtBase = (baseCell == 'B' || baseCell == 'S') ? 2 : 1;
+
+    for (size_t ci = 0; ci < couriers.size(); ++ci)
+    {
+        Courier &c = *couriers[ci];
+        int left = ticks;
+        for (; left > 0 && !c.isDead() && !atBase(c, map->basePos); --left)
+            advanceCourier(ci);
+        if (left == 0 || c.isDead())
+            continue;
+        // idle at base for the rest: a quarter recharge in the idle branch and
+        // another for standing on the base cell, every tick
+        ledger.onOperatingCost(c.getCost() * left);
+        ledger.onCourierTicks(c.kind(), left, false);
+        const long long gain = (long long)rechargesAtBase * left * (c.getMaxBattery() / 4);
+        c.recharge((int)std::min<long long>(gain, c.getMaxBattery()));
+    }
+
+    currentTick += ticks;
+    skippedTicks += ticks;
+    lastDispatchPackages = lastDispatchSlots = lastDispatchMicros = 0;
+    phaseTimes.movement += std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    phaseAllocs.movement += AllocTracker::lap(allocMark);
+    if (telemetry && currentTick % std::max(1, cfg.telemetryInterval) == 0)
+        recordTelemetry();
+}
+
+int Simulation::advance(int maxTicks)
+{
+    AllocCounts allocMark = AllocTracker::thisThread();
+    const int startTick = currentTick;
+    const int idle = cfg.eventEngine ? std::min(idleTicksAvailable(), maxTicks) : 0;
+    if (idle > 0)
+        fastForward(idle);
+    else
+        step();
+    if (AllocTracker::compiledIn)
+    {
+        const AllocCounts tick = AllocTracker::lap(allocMark);
+        tickAllocations.record(tick.allocations);
+        tickAllocBytes.record(tick.bytes);
+    }
+    // between ticks no worker thread is recording
+    if (tracer && tracer->takeExportRequest())
+        exportTrace();
+    return currentTick - startTick;
+}
@@ -6,7 +6,7 @@
 
 FileMapLoader::FileMapLoader(std::string p) : path(std::move(p)) {}
 
-void FileMapLoader::generate(Config& cfg, std::mt19937& /*rng*/, std::vector<std::string>& grid,
+void FileMapLoader::generate(Config& cfg, CounterRng& /*rng*/, std::vector<std::string>& grid,
                               Vec2& basePos, std::vector<Vec2>& clients, std::vector<Vec2>& stations) {
     std::ifstream in(path);
     if (!in) {
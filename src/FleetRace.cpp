@@ -0,0 +1,125 @@
+#include "FleetRace.h"
+
+#include <algorithm>
+#include <cmath>
+
+double FleetCandidate::mean() const
+{
+    double sum = 0;
+    int n = 0;
+    for (double p : profits)
+    {
+        if (std::isnan(p))
+            continue;
+        sum += p;
+        ++n;
+    }
+    return n ? sum / n : 0;
+}
+
+FleetRace::FleetRace(std::vector<FleetCandidate> candidates, int initialSeeds, int maxSeeds, double eta,
+                     int finalists)
+    : all(std::move(candidates)), maxSeeds(std::max(1, maxSeeds)), eta(std::max(1.5, eta)),
+      finalists(std::max(1, finalists)), seeds(std::min(std::max(1, initialSeeds), this->maxSeeds))
+{
+    for (FleetCandidate &c : all)
+        c.profits.assign(seeds, std::nan(""));
+}
+
+std::vector<std::pair<int, int>> FleetRace::pendingRuns() const
+{
+    std::vector<std::pair<int, int>> runs;
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        if (!all[i].alive())
+            continue;
+        for (int s = 0; s < seeds; ++s)
+            if (std::isnan(all[i].profits[s]))
+                runs.push_back({(int)i, s});
+    }
+    return runs;
+}
+
+void FleetRace::record(int candidate, int seedIndex, double profit)
+{
+    all[candidate].profits[seedIndex] = profit;
+}
+
+void FleetRace::recordCrash(int candidate)
+{
+    FleetCandidate &c = all[candidate];
+    ++c.crashes;
+    if (c.alive())
+        c.eliminatedInRound = roundNo;
+}
+
+double FleetRace::tCritical(int df)
+{
+    static const double table[] = {12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36, 2.31, 2.26, 2.23,
+                                   2.20,  2.18, 2.16, 2.14, 2.13, 2.12, 2.11, 2.10, 2.09, 2.09};
+    if (df < 1)
+        return INFINITY;
+    if (df <= 20)
+        return table[df - 1];
+    return df <= 30 ? 2.05 : 1.96;
+}
+
+bool FleetRace::worseThan(const FleetCandidate &c, const FleetCandidate &best) const
+{
+    // paired on the seed: both saw the same maps and demand
+    const int n = (int)c.profits.size();
+    if (n < 2)
+        return false;
+    double sum = 0, sumSq = 0;
+    for (int s = 0; s < n; ++s)
+    {
+        const double d = best.profits[s] - c.profits[s];
+        sum += d;
+        sumSq += d * d;
+    }
+    const double mean = sum / n;
+    const double var = std::max(0.0, (sumSq - n * mean * mean) / (n - 1));
+    return mean - tCritical(n - 1) * std::sqrt(var / n) > 0;
+}
+
+int FleetRace::leader() const
+{
+    int best = -1;
+    for (size_t i = 0; i < all.size(); ++i)
+        if (all[i].alive() && (best < 0 || all[i].mean() > all[best].mean()))
+            best = (int)i;
+    return best;
+}
+
+bool FleetRace::nextRound()
+{
+    const int lead = leader();
+    if (lead < 0)
+        return false;
+    std::vector<int> alive;
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        if (!all[i].alive() || (int)i == lead)
+            continue;
+        if (worseThan(all[i], all[lead]))
+            all[i].eliminatedInRound = roundNo;
+        else
+            alive.push_back((int)i);
+    }
+    alive.push_back(lead);
+    if ((int)alive.size() > finalists)
+    {
+        std::sort(alive.begin(), alive.end(), [this](int a, int b) { return all[a].mean() > all[b].mean(); });
+        const int keep = std::max(finalists, (int)std::ceil(alive.size() / eta));
+        for (size_t k = keep; k < alive.size(); ++k)
+            all[alive[k]].eliminatedInRound = roundNo;
+        alive.resize(keep);
+    }
+    if (alive.size() == 1 || seeds >= maxSeeds)
+        return false;
+    ++roundNo;
+    seeds = std::min(maxSeeds, seeds * 2);
+    for (int i : alive)
+        all[i].profits.resize(seeds, std::nan(""));
+    return true;
+}
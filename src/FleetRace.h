@@ -0,0 +1,55 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+// One fleet mix under evaluation.
+struct FleetCandidate {
+    int drones = 0, robots = 0, scooters = 0, stations = 0; // hive_fleet: -1 keeps the config value
+    std::vector<double> profits; // by seed index; runs of a round may arrive in any order (NaN = no result)
+    int eliminatedInRound = -1;  // -1 while still racing
+    int crashes = 0;             // replicas that died without a profit
+
+    double mean() const; // over the runs that produced a profit
+    bool alive() const { return eliminatedInRound < 0; }
+};
+
+// Successive halving with statistical racing over simulation replicas.
+// Every round all surviving candidates are run on the same seeds (common
+// random numbers), the seed count doubling from round to round up to
+// maxSeeds. After a round a candidate is dropped when a paired t-test shows
+// it is worse than the leader, and while more than `finalists` remain only
+// the better 1/eta of them go on. Most replicas are thus spent on the few
+// candidates that are still hard to tell apart.
+class FleetRace {
+public:
+    FleetRace(std::vector<FleetCandidate> candidates, int initialSeeds, int maxSeeds, double eta = 2.0,
+              int finalists = 3);
+
+    // (candidate, seed index) replicas the current round still needs
+    std::vector<std::pair<int, int>> pendingRuns() const;
+    void record(int candidate, int seedIndex, double profit);
+    // A replica that failed has no profit to compare; its candidate is
+    // dropped in the current round rather than scored.
+    void recordCrash(int candidate);
+    // Applies the eliminations once every pending run is recorded; false
+    // when the race is over (one survivor, or the survivors ran maxSeeds).
+    bool nextRound();
+
+    const std::vector<FleetCandidate>& candidates() const { return all; }
+    int leader() const; // best surviving mean
+    int round() const { return roundNo; }
+    int seedsThisRound() const { return seeds; }
+
+    // two-sided 95% Student t quantile for `df` degrees of freedom
+    static double tCritical(int df);
+
+private:
+    std::vector<FleetCandidate> all;
+    int maxSeeds;
+    double eta;
+    int finalists;
+    int roundNo = 0;
+    int seeds;
+    bool worseThan(const FleetCandidate& c, const FleetCandidate& best) const;
+};
@@ -0,0 +1,138 @@
+#include "FrameExporter.h"
+#include "Errors.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+const uint8_t FrameExporter::palette[PaletteSize][3] = {
+    {24, 24, 24},    // road
+    {150, 150, 150}, // wall
+    {0, 200, 0},     // client (green)
+    {0, 230, 230},   // base (bright cyan)
+    {230, 200, 0},   // station (yellow)
+    {60, 90, 255},   // drone (blue)
+    {120, 255, 120}, // robot (bright green)
+    {230, 0, 230},   // scooter (magenta)
+};
+
+FrameExporter::Color FrameExporter::colorOf(char cell)
+{
+    switch (cell)
+    {
+    case '#':
+        return Wall;
+    case 'D':
+        return Client;
+    case 'B':
+        return Base;
+    case 'S':
+        return Station;
+    default:
+        return Road;
+    }
+}
+
+FrameExporter::FrameExporter(const std::string &directory, int rows, int cols, int scale, size_t capacity)
+    : dir(directory), rows(rows), cols(cols), scale(std::max(1, scale)), slots(std::max<size_t>(1, capacity))
+{
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        throw FileOpenError("Could not create frame directory: " + dir + " (" + std::strerror(errno) + ")\n");
+    for (Slot &s : slots)
+        s.cells.assign((size_t)rows * cols, Road);
+    writer = std::thread([this] { writerLoop(); });
+}
+
+FrameExporter::~FrameExporter()
+{
+    close();
+}
+
+uint8_t *FrameExporter::acquire()
+{
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= slots.size())
+    {
+        droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return slots[h % slots.size()].cells.data();
+}
+
+void FrameExporter::publish(int tick)
+{
+    const size_t h = head.load(std::memory_order_relaxed);
+    slots[h % slots.size()].tick = tick;
+    head.store(h + 1, std::memory_order_release);
+    // the lock only orders this wake-up against the writer going to sleep
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+}
+
+void FrameExporter::close()
+{
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        closing = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+void FrameExporter::writerLoop()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return closing || head.load(std::memory_order_acquire) != tail.load(); });
+        }
+        // drain everything published so far, then look at `closing` again
+        size_t t = tail.load(std::memory_order_relaxed);
+        while (t != head.load(std::memory_order_acquire))
+        {
+            if (writeFrame(slots[t % slots.size()]))
+                writtenFrames.fetch_add(1, std::memory_order_relaxed);
+            else
+                droppedFrames.fetch_add(1, std::memory_order_relaxed);
+            tail.store(++t, std::memory_order_release);
+        }
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        if (closing && head.load(std::memory_order_acquire) == t)
+            return;
+    }
+}
+
+bool FrameExporter::writeFrame(const Slot &slot)
+{
+    char header[64];
+    const int len = std::snprintf(header, sizeof header, "P6\n%d %d\n255\n", cols * scale, rows * scale);
+    const size_t rowBytes = (size_t)cols * scale * 3;
+    encoded.assign(header, header + len);
+    encoded.resize(len + rowBytes * rows * scale);
+    char *px = encoded.data() + len;
+    for (int x = 0; x < rows; ++x)
+    {
+        char *first = px;
+        for (int y = 0; y < cols; ++y)
+        {
+            const uint8_t *rgb = palette[slot.cells[(size_t)x * cols + y] % PaletteSize];
+            for (int k = 0; k < scale; ++k, px += 3)
+                std::memcpy(px, rgb, 3);
+        }
+        for (int k = 1; k < scale; ++k, px += rowBytes)
+            std::memcpy(px, first, rowBytes); // the cell's remaining pixel rows
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof name, "/frame_%06d.ppm", slot.tick);
+    std::FILE *f = std::fopen((dir + name).c_str(), "wb");
+    if (!f)
+        return false;
+    const bool ok = std::fwrite(encoded.data(), 1, encoded.size(), f) == encoded.size();
+    return std::fclose(f) == 0 && ok;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Exports ticks as an image sequence (FRAME_DIR: ...). A frame is one palette
+// index per cell; the simulation thread fills a slot of a bounded ring in
+// place and a background thread encodes it as a binary PPM (scale x scale
+// pixels per cell) into <dir>/frame_<tick>.ppm. When the writer falls behind
+// the ring fills up and new frames are dropped and counted, so the simulation
+// never waits on the disk. Frames the writer fails to save count as dropped.
+class FrameExporter {
+public:
+    // colours of the terminal legend in Simulation::render()
+    enum Color : uint8_t { Road, Wall, Client, Base, Station, Drone, Robot, Scooter, PaletteSize };
+    static Color colorOf(char cell); // map characters: '.', '#', 'D', 'B', 'S'
+    static const uint8_t palette[PaletteSize][3];
+
+    // Creates `directory` if needed; throws FileOpenError when it cannot.
+    FrameExporter(const std::string& directory, int rows, int cols, int scale, size_t capacity);
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    // The next free slot (rows * cols indices, row-major), or nullptr - and a
+    // dropped frame - when the ring is full. Simulation thread only.
+    uint8_t* acquire();
+    // hands the slot from the last successful acquire() to the writer
+    void publish(int tick);
+    // writes out every queued frame and stops the writer; safe to call twice
+    void close();
+
+    long long written() const { return writtenFrames.load(); }
+    long long dropped() const { return droppedFrames.load(); }
+    size_t capacity() const { return slots.size(); }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> cells;
+        int tick = 0;
+    };
+
+    void writerLoop();
+    bool writeFrame(const Slot& slot);
+
+    std::string dir;
+    int rows, cols, scale;
+    std::vector<Slot> slots;
+    std::vector<char> encoded; // writer thread only: one PPM file
+
+    std::atomic<size_t> head{0}; // frames published (producer)
+    std::atomic<size_t> tail{0}; // frames written or failed (writer)
+    std::atomic<long long> writtenFrames{0};
+    std::atomic<long long> droppedFrames{0};
+
+    std::mutex wakeMutex; // only guards the sleep/wake handshake, never I/O
+    std::condition_variable wake;
+    bool closing = false;
+    std::thread writer;
+};
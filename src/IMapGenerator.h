@@ -1,8 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
-#include <random>
+#include "CounterRng.h"
 #include "Courier.h" // for Vec2
 
 struct Config; // forward declaration; defined in Simulation.h
@@ -13,9 +14,21 @@ public:
 
     // Generate fills grid, basePos, clients and stations. It may also update cfg (e.g., rows/cols)
     virtual void generate(Config& cfg,
-                          std::mt19937& rng,
+                          CounterRng& rng,
                           std::vector<std::string>& grid,
                           Vec2& basePos,
                           std::vector<Vec2>& clients,
                           std::vector<Vec2>& stations) = 0;
+
+    // True if every client and station is always reachable from the base on
+    // the generated map, letting Simulation skip the validation BFS.
+    virtual bool guaranteesConnectivity() const { return false; }
+
+    // True if another call to generate (with a different rng attempt) can
+    // produce a different map, so an invalid one is worth retrying.
+    virtual bool canRegenerate() const { return false; }
 };
+
+// The generator named by MAP_GENERATOR ("PROCEDURAL", "NOISE"); nullptr if
+// the name is unknown.
+std::unique_ptr<IMapGenerator> makeMapGenerator(const std::string& kind);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Courier.h" // for Vec2
+
+// Running KPIs of a run, updated in O(1) at each event (spawn, assignment,
+// delivery, courier status change, death, operating cost). Rendering, the
+// report, telemetry and the stop condition read these instead of rescanning
+// packages and couriers.
+struct KpiLedger {
+    int spawned = 0;   // packages created
+    int assigned = 0;  // packages that left the waiting pool
+    int delivered = 0;
+    int deliveredLate = 0;
+    long long latenessTicks = 0;
+    long long rewardDelivered = 0;
+    int operatingCost = 0;
+    int deadAgents = 0;
+    int activeCouriers = 0;   // alive and carrying or away from base
+    int carryingCouriers = 0; // alive and carrying at least one package
+
+    // cumulative per courier type, indexed by CourierKind
+    struct FleetKpis {
+        long long aliveTicks = 0;
+        long long busyTicks = 0;  // alive and carrying or away from base
+        long long energyUsed = 0; // battery spent on moves
+        long long distance = 0;   // cells travelled
+        int deaths = 0;
+    };
+    FleetKpis fleet[3];
+
+    // scoring constants shared by the live estimate and the final report
+    static constexpr int latePenalty = 50;
+    static constexpr int lostPenalty = 200;
+    static constexpr int deathPenalty = 500;
+
+    struct CourierStatus {
+        bool active = false;
+        bool carrying = false;
+    };
+    static CourierStatus statusOf(const Courier& c, const Vec2& base)
+    {
+        CourierStatus s;
+        if (c.isDead())
+            return s;
+        s.carrying = !c.getPackages().empty();
+        s.active = s.carrying || c.getPos().x != base.x || c.getPos().y != base.y;
+        return s;
+    }
+
+    void onSpawn() { ++spawned; }
+    void onAssign() { ++assigned; }
+    void onDeliver(int reward, int tick, int deadline)
+    {
+        ++delivered;
+        rewardDelivered += reward;
+        if (tick > deadline)
+        {
+            ++deliveredLate;
+            latenessTicks += tick - deadline;
+        }
+    }
+    void onOperatingCost(int cost) { operatingCost += cost; }
+    void onCourierDeath(CourierKind k)
+    {
+        ++deadAgents;
+        ++fleet[(int)k].deaths;
+    }
+    void onCourierTicks(CourierKind k, int ticks, bool busy)
+    {
+        fleet[(int)k].aliveTicks += ticks;
+        if (busy)
+            fleet[(int)k].busyTicks += ticks;
+    }
+    void onTravel(CourierKind k, int cells, int energy)
+    {
+        fleet[(int)k].distance += cells;
+        fleet[(int)k].energyUsed += energy;
+    }
+    void onCourierStatus(CourierStatus before, CourierStatus after)
+    {
+        activeCouriers += (int)after.active - (int)before.active;
+        carryingCouriers += (int)after.carrying - (int)before.carrying;
+    }
+
+    // profit so far, without the penalty for packages not yet delivered
+    long long provisionalProfit() const
+    {
+        return rewardDelivered - (long long)latePenalty * deliveredLate - operatingCost -
+               (long long)deathPenalty * deadAgents;
+    }
+    int lost() const { return spawned - delivered; }
+    // end-of-run profit: every spawned package still undelivered counts as lost
+    long long finalProfit() const { return provisionalProfit() - (long long)lostPenalty * lost(); }
+};
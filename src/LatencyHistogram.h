@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-size log-linear histogram of non-negative samples (microseconds,
+// ticks). Values below 64 are exact; above that each power of two is split
+// into 32 buckets, so a reported percentile is within ~3% of the true sample.
+// The memory is constant however many samples a run records.
+class LatencyHistogram {
+public:
+    LatencyHistogram() : buckets(64 + 58 * 32, 0) {}
+
+    void record(long long v)
+    {
+        if (v < 0)
+            v = 0;
+        ++buckets[bucketOf((uint64_t)v)];
+        ++n;
+        if (v > maxSeen)
+            maxSeen = v;
+    }
+
+    long long count() const { return n; }
+    long long max() const { return maxSeen; }
+
+    // smallest bucket bound covering fraction q of the samples (0 if empty)
+    long long percentile(double q) const
+    {
+        if (n == 0)
+            return 0;
+        long long rank = (long long)(q * n + 0.999999);
+        if (rank < 1)
+            rank = 1;
+        long long seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return upperBound(b) < maxSeen ? upperBound(b) : maxSeen;
+        }
+        return maxSeen;
+    }
+
+private:
+    std::vector<long long> buckets;
+    long long n = 0;
+    long long maxSeen = 0;
+
+    static size_t bucketOf(uint64_t v)
+    {
+        if (v < 64)
+            return (size_t)v;
+        int top = 63 - __builtin_clzll(v); // >= 6
+        int shift = top - 5;
+        return 64 + (size_t)(top - 6) * 32 + (size_t)((v >> shift) - 32);
+    }
+    static long long upperBound(size_t b)
+    {
+        if (b < 64)
+            return (long long)b;
+        size_t e = (b - 64) / 32, sub = (b - 64) % 32;
+        int shift = (int)e + 1;
+        return (long long)(((32 + sub + 1) << shift) - 1);
+    }
+};
@@ -0,0 +1,218 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Rolling-horizon dispatch.
+//
+// The myopic dispatcher (hiveMindDispatch) only scores pairs at the current
+// tick. Here we take its plan as the first candidate, derive a few
+// alternatives from it (hold everything back for a tick, or defer one of the
+// weakest assignments so a courier that frees up soon can take it), and roll a
+// fork of the simulation forward for each candidate. Forks share the immutable
+// map, never render, and use the myopic dispatcher internally. The candidate
+// with the best provisional profit at the deepest horizon reached by all
+// rollouts within the budget is committed; only its first step is applied.
+
+namespace {
+
+struct PlannedAssignment
+{
+    int courierIdx;
+    int packageId;
+};
+
+using Plan = std::vector<PlannedAssignment>;
+
+struct Rollout
+{
+    Plan plan;
+    std::vector<long long> profitAtDepth; // provisional profit after each simulated tick
+};
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+void Simulation::lookaheadDispatch()
+{
+    if (packagePool.empty())
+        return;
+
+    const Clock::time_point deadline = Clock::now() + std::chrono::microseconds(std::max(0, cfg.lookaheadBudgetUs));
+
+    // Candidate 0: what the myopic dispatcher would do right now. Run it on a
+    // fork and read back the new assignments so nothing is committed yet.
+    TraceSpan span("lookahead");
+    std::unique_ptr<Simulation> probe = fork();
+    probe->quiet = true;
+    probe->cfg.lookaheadHorizon = 0;
+    probe->plannersInPlace = true; // same thread and map: its queries warm our planners
+    probe->hiveMindDispatch();
+
+    Plan myopic;
+    for (size_t i = 0; i < couriers.size(); ++i)
+    {
+        const auto &before = couriers[i]->getPackages();
+        const auto &after = probe->couriers[i]->getPackages();
+        for (size_t k = before.size(); k < after.size(); ++k)
+            myopic.push_back({(int)i, after[k]->getId()});
+    }
+    const bool probeDeliveredAll = probe->allDelivered;
+    probe.reset(); // or our own queries below would copy the planners it shares
+
+    // assigned packages leave the pool; plans are a handful of entries, so
+    // they are looked up directly rather than marked in a per-package table
+    auto commit = [&](const Plan &plan) {
+        std::vector<int> taken;
+        for (const auto &a : plan)
+        {
+            if (assignToCourier(*couriers[a.courierIdx], packages[a.packageId].get()))
+                taken.push_back(a.packageId);
+        }
+        if (taken.empty())
+            return;
+        std::sort(taken.begin(), taken.end());
+        packagePool.erase(std::remove_if(packagePool.begin(), packagePool.end(),
+                                         [&](Package *p) {
+                                             return std::binary_search(taken.begin(), taken.end(), p->getId());
+                                         }),
+                          packagePool.end());
+    };
+
+    // the probe is part of the budget too; if it used it all up there is no
+    // time left to compare candidates
+    const bool probeOverran = Clock::now() >= deadline;
+    if (probeOverran)
+        ++lookaheadBudgetHits;
+
+    if (myopic.empty() || probeOverran)
+    {
+        // nothing to choose between (or no time to); commit the myopic plan and
+        // keep any end-of-run decision it made
+        commit(myopic);
+        if (probeDeliveredAll)
+            setAllDelivered();
+        return;
+    }
+
+    std::vector<Rollout> rollouts;
+    rollouts.push_back({myopic, {}});
+    if (cfg.lookaheadCandidates > 1)
+        rollouts.push_back({Plan{}, {}}); // hold everything for one tick
+
+    // defer the weakest assignments first; they are the likeliest to be beaten
+    // by a courier that becomes free a few ticks from now
+    std::vector<std::pair<int, int>> byScore; // (score, index into myopic)
+    for (size_t k = 0; k < myopic.size(); ++k)
+    {
+        Courier *c = couriers[myopic[k].courierIdx].get();
+        byScore.push_back({computePriority(c, packages[myopic[k].packageId].get()), (int)k});
+    }
+    std::sort(byScore.begin(), byScore.end());
+    for (const auto &entry : byScore)
+    {
+        if ((int)rollouts.size() >= cfg.lookaheadCandidates || myopic.size() < 2)
+            break;
+        Plan deferred = myopic;
+        deferred.erase(deferred.begin() + entry.second);
+        rollouts.push_back({deferred, {}});
+    }
+
+    // Every rollout samples the same hypothetical future (common random
+    // numbers) from a stream of its own, so plans are compared fairly and
+    // never see the packages the real run will spawn.
+    const int horizon = cfg.lookaheadHorizon;
+    std::atomic<bool> budgetHit{false};
+
+    auto evaluate = [&](Rollout &r) {
+        TraceSpan rollout("rollout", "candidate", (int)(&r - rollouts.data()));
+        if (Clock::now() >= deadline)
+        {
+            budgetHit = true; // not even time to fork
+            return;
+        }
+        std::unique_ptr<Simulation> sim = fork();
+        sim->quiet = true;
+        sim->cfg.lookaheadHorizon = 0;
+        sim->spawnStream = RngStream::LookaheadSpawn;
+        for (const auto &a : r.plan)
+        {
+            if (sim->assignToCourier(*sim->couriers[a.courierIdx], sim->packages[a.packageId].get()))
+            {
+                auto &pool = sim->packagePool;
+                pool.erase(std::remove(pool.begin(), pool.end(), sim->packages[a.packageId].get()), pool.end());
+            }
+        }
+        // the first simulated tick finishes the current one with this plan;
+        // after that the myopic policy dispatches inside the fork
+        for (int t = 0; t < horizon; ++t)
+        {
+            if (Clock::now() >= deadline)
+            {
+                budgetHit = true;
+                return;
+            }
+            if (t > 0 && (sim->isAllDelivered() || sim->currentTick >= sim->cfg.maxTicks))
+            {
+                // nothing left to simulate; the profit is final
+                r.profitAtDepth.resize(horizon, r.profitAtDepth.back());
+                return;
+            }
+            if (t == 0)
+                sim->advanceCouriers();
+            else
+                sim->step();
+            r.profitAtDepth.push_back(sim->ledger.provisionalProfit());
+        }
+    };
+
+    int threads = cfg.lookaheadThreads > 0 ? cfg.lookaheadThreads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min(threads, (int)rollouts.size()));
+    if (threads == 1)
+    {
+        for (auto &r : rollouts)
+            evaluate(r);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        std::vector<AllocCounts> workerAllocs(threads);
+        for (int w = 0; w < threads; ++w)
+        {
+            workers.emplace_back([&, w]() {
+                const AllocCounts mark = AllocTracker::thisThread();
+                for (size_t i = w; i < rollouts.size(); i += threads)
+                    evaluate(rollouts[i]);
+                workerAllocs[w] = AllocTracker::thisThread() - mark;
+            });
+        }
+        for (auto &t : workers)
+            t.join();
+        for (const AllocCounts &a : workerAllocs)
+            AllocTracker::credit(a); // the dispatch phase caused them
+    }
+    if (budgetHit)
+        ++lookaheadBudgetHits;
+
+    // compare at the deepest horizon every candidate reached
+    size_t depth = rollouts[0].profitAtDepth.size();
+    for (const auto &r : rollouts)
+        depth = std::min(depth, r.profitAtDepth.size());
+
+    size_t best = 0;
+    if (depth > 0)
+    {
+        for (size_t i = 1; i < rollouts.size(); ++i)
+        {
+            if (rollouts[i].profitAtDepth[depth - 1] > rollouts[best].profitAtDepth[depth - 1])
+                best = i;
+        }
+    }
+    if (best != 0)
+        ++lookaheadOverrides;
+    commit(rollouts[best].plan);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "Courier.h" // for Vec2
+
+// Immutable map contents produced by an IMapGenerator. Held through a
+// shared_ptr<const MapData> so forked simulations can share one copy.
+struct MapData {
+    std::vector<std::string> grid; // rows strings of length cols
+    Vec2 basePos{0, 0};
+    std::vector<Vec2> clients;
+    std::vector<Vec2> stations;
+};
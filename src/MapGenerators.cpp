@@ -0,0 +1,12 @@
+#include "IMapGenerator.h"
+#include "NoiseMapGenerator.h"
+#include "ProceduralMapGenerator.h"
+
+std::unique_ptr<IMapGenerator> makeMapGenerator(const std::string& kind)
+{
+    if (kind == "NOISE")
+        return std::make_unique<NoiseMapGenerator>();
+    if (kind == "PROCEDURAL")
+        return std::make_unique<ProceduralMapGenerator>();
+    return nullptr;
+}
@@ -0,0 +1,280 @@
+#include "NoiseMapGenerator.h"
+#include "Simulation.h" // for Config
+#include "Errors.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace {
+
+const int tileRows = 32;
+
+// Integer lattice hash; the whole noise pipeline is branch-free arithmetic on
+// it so the per-row loops below vectorise.
+inline uint32_t hash2(uint32_t ix, uint32_t iy, uint32_t seed)
+{
+    uint32_t h = ix * 0x27d4eb2du ^ iy * 0x165667b1u ^ seed * 0x9e3779b9u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return h;
+}
+
+inline float gradDot(uint32_t h, float dx, float dy)
+{
+    float gx = (float)(h & 0xffffu) * (1.0f / 32768.0f) - 1.0f;
+    float gy = (float)(h >> 16) * (1.0f / 32768.0f) - 1.0f;
+    return gx * dx + gy * dy;
+}
+
+inline float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// 2D gradient (Perlin) noise for x, y >= 0, roughly in [-1, 1].
+inline float gradientNoise(float x, float y, uint32_t seed)
+{
+    int ix = (int)x; // truncation == floor for non-negative inputs
+    int iy = (int)y;
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+    float n00 = gradDot(hash2(ix, iy, seed), fx, fy);
+    float n10 = gradDot(hash2(ix + 1, iy, seed), fx - 1.0f, fy);
+    float n01 = gradDot(hash2(ix, iy + 1, seed), fx, fy - 1.0f);
+    float n11 = gradDot(hash2(ix + 1, iy + 1, seed), fx - 1.0f, fy - 1.0f);
+    float u = fade(fx);
+    float v = fade(fy);
+    float a = n00 + u * (n10 - n00);
+    float b = n01 + u * (n11 - n01);
+    return a + v * (b - a);
+}
+
+// One row of noise at frequency `freq`; the loop body has no calls or
+// branches so the compiler emits SIMD code for it.
+void noiseRow(float *out, int x, int cols, float freq, float amplitude, uint32_t seed)
+{
+    const float fx = (float)x * freq;
+    for (int y = 0; y < cols; ++y)
+        out[y] = amplitude * gradientNoise(fx, (float)y * freq, seed);
+}
+
+// Street test on the warped lattice plus park threshold, written as a flat
+// branch-free loop over raw arrays so it vectorises like noiseRow.
+void classifyRow(unsigned char *__restrict street, char *__restrict row, const float *__restrict warpX,
+                 const float *__restrict warpY, const float *__restrict park, int x, int cols,
+                 float offset, float block, float streetFrac, float parkThreshold)
+{
+    for (int y = 0; y < cols; ++y)
+    {
+        float sx = ((float)x + warpX[y] + offset) / block;
+        float sy = ((float)y + warpY[y] + offset) / block;
+        float fx = sx - (float)(int)sx;
+        float fy = sy - (float)(int)sy;
+        int isStreet = (fx < streetFrac) | (fy < streetFrac);
+        int isOpen = isStreet | (park[y] > parkThreshold);
+        street[y] = (unsigned char)isStreet;
+        row[y] = (char)('#' + isOpen * ('.' - '#'));
+    }
+}
+
+// Weighted sampling without replacement (Efraimidis-Spirakis): each cell
+// gets key log(u) / w and the K largest keys win. Keys are a pure function of
+// the cell, so per-tile top-K lists merge into the same answer on any
+// schedule.
+using Candidate = std::pair<float, int>; // (key, cell index)
+
+void keepTopK(std::vector<Candidate> &heap, size_t k, Candidate c)
+{
+    auto cmp = [](const Candidate &a, const Candidate &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    if (heap.size() < k)
+    {
+        heap.push_back(c);
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+    else if (k > 0 && cmp(c, heap.front()))
+    {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        heap.back() = c;
+        std::push_heap(heap.begin(), heap.end(), cmp);
+    }
+}
+
+struct TileResult
+{
+    std::vector<Candidate> clients;
+    std::vector<Candidate> stations;
+};
+
+} // namespace
+
+NoiseMapGenerator::NoiseMapGenerator(int blockSize, int streetWidth, double parkThreshold, int threads)
+    : blockSize(std::max(3, blockSize)),
+      streetWidth(std::max(1, std::min(streetWidth, blockSize - 1))),
+      parkThreshold((float)parkThreshold),
+      threads(threads) {}
+
+void NoiseMapGenerator::generate(Config &cfg, CounterRng &rng, std::vector<std::string> &grid,
+                                 Vec2 &basePos, std::vector<Vec2> &clients, std::vector<Vec2> &stations)
+{
+    const int rows = cfg.rows;
+    const int cols = cfg.cols;
+    const uint32_t seed = (uint32_t)rng();
+
+    grid.assign(rows, std::string(cols, '#'));
+
+    const float block = (float)blockSize;
+    const float streetFrac = (float)streetWidth / block;
+    // the warp bends streets by up to a quarter block over four blocks, gentle
+    // enough that streets rarely break up; the map is still validated
+    const float warpFreq = 1.0f / (4.0f * block);
+    const float warpAmp = block / 4.0f;
+    const float parkFreq = 1.0f / (1.5f * block);
+    const float densityFreq = 1.0f / (6.0f * block);
+    const float offset = 4.0f * block; // keeps warped coordinates positive
+
+    // one spare slot each in case the base lands on a chosen cell
+    const size_t wantClients = (size_t)std::max(0, cfg.clientsCount) + 1;
+    const size_t wantStations = (size_t)std::max(0, cfg.maxStations) + wantClients + 1;
+
+    const int tiles = (rows + tileRows - 1) / tileRows;
+    std::vector<TileResult> results(tiles);
+    std::atomic<int> nextTile{0};
+
+    auto worker = [&]() {
+        std::vector<float> warpX(cols), warpY(cols), park(cols), density(cols);
+        std::vector<unsigned char> street(cols);
+        for (int t = nextTile++; t < tiles; t = nextTile++)
+        {
+            TileResult &res = results[t];
+            float clientCut = 0.0f, stationCut = 0.0f;
+            const int r1 = std::min(rows, (t + 1) * tileRows);
+            for (int x = t * tileRows; x < r1; ++x)
+            {
+                char *row = &grid[x][0];
+                noiseRow(warpX.data(), x, cols, warpFreq, warpAmp, seed ^ 0x1u);
+                noiseRow(warpY.data(), x, cols, warpFreq, warpAmp, seed ^ 0x2u);
+                noiseRow(park.data(), x, cols, parkFreq, 1.0f, seed ^ 0x3u);
+                noiseRow(density.data(), x, cols, densityFreq, 0.5f, seed ^ 0x4u);
+
+                classifyRow(street.data(), row, warpX.data(), warpY.data(), park.data(), x, cols,
+                            offset, block, streetFrac, parkThreshold);
+
+                // POIs only go on streets, so they are usually reachable.
+                // Keys are log(u) / w <= log(u) since w <= 1, so once a list is
+                // full any u below exp(smallest kept key) cannot enter it.
+                for (int y = 0; y < cols; ++y)
+                {
+                    if (!street[y])
+                        continue;
+                    float w = 0.5f + density[y]; // in [0, 1]
+                    w = std::max(1e-3f, w * w * w);
+                    int idx = x * cols + y;
+                    float uc = ((float)(hash2(x, y, seed ^ 0x5u) >> 8) + 1.0f) * (1.0f / 16777217.0f);
+                    if (uc > clientCut)
+                    {
+                        keepTopK(res.clients, wantClients, {std::log(uc) / w, idx});
+                        if (res.clients.size() == wantClients)
+                            clientCut = std::exp(res.clients.front().first);
+                    }
+                    // stations spread out more evenly than demand
+                    float us = ((float)(hash2(x, y, seed ^ 0x6u) >> 8) + 1.0f) * (1.0f / 16777217.0f);
+                    if (us > stationCut)
+                    {
+                        keepTopK(res.stations, wantStations, {std::log(us) / std::sqrt(w), idx});
+                        if (res.stations.size() == wantStations)
+                            stationCut = std::exp(res.stations.front().first);
+                    }
+                }
+            }
+        }
+    };
+
+    int n = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    n = std::max(1, std::min(n, tiles));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < n; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool)
+        th.join();
+
+    // same test as the tile loop, for single cells
+    auto isStreet = [&](int x, int y) {
+        float wx = warpAmp * gradientNoise(x * warpFreq, y * warpFreq, seed ^ 0x1u);
+        float wy = warpAmp * gradientNoise(x * warpFreq, y * warpFreq, seed ^ 0x2u);
+        float sx = ((float)x + wx + offset) / block;
+        float sy = ((float)y + wy + offset) / block;
+        return (sx - (float)(int)sx) < streetFrac || (sy - (float)(int)sy) < streetFrac;
+    };
+
+    // base: the street cell nearest the centre (ring search)
+    basePos = {rows / 2, cols / 2};
+    bool baseFound = false;
+    for (int radius = 0; !baseFound && radius < std::max(rows, cols); ++radius)
+    {
+        for (int dx = -radius; dx <= radius && !baseFound; ++dx)
+        {
+            for (int dy = -radius; dy <= radius && !baseFound; ++dy)
+            {
+                if (std::max(std::abs(dx), std::abs(dy)) != radius)
+                    continue;
+                int x = rows / 2 + dx, y = cols / 2 + dy;
+                if (x < 0 || y < 0 || x >= rows || y >= cols)
+                    continue;
+                if (isStreet(x, y))
+                {
+                    basePos = {x, y};
+                    baseFound = true;
+                }
+            }
+        }
+    }
+    if (!baseFound)
+        throw MapGenerationError("Noise map has no street cell for the base\n");
+    grid[basePos.x][basePos.y] = 'B';
+
+    auto merge = [&](std::vector<Candidate> TileResult::*list) {
+        std::vector<Candidate> all;
+        for (auto &r : results)
+            all.insert(all.end(), (r.*list).begin(), (r.*list).end());
+        std::sort(all.begin(), all.end(), [](const Candidate &a, const Candidate &b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        return all;
+    };
+
+    clients.clear();
+    for (const Candidate &c : merge(&TileResult::clients))
+    {
+        if ((int)clients.size() >= cfg.clientsCount)
+            break;
+        int x = c.second / cols, y = c.second % cols;
+        if (grid[x][y] != '.')
+            continue;
+        grid[x][y] = 'D';
+        clients.push_back({x, y});
+    }
+
+    stations.clear();
+    for (const Candidate &c : merge(&TileResult::stations))
+    {
+        if ((int)stations.size() >= cfg.maxStations)
+            break;
+        int x = c.second / cols, y = c.second % cols;
+        if (grid[x][y] != '.')
+            continue;
+        grid[x][y] = 'S';
+        stations.push_back({x, y});
+    }
+    // tiny maps may not have enough street cells; the lists then come up
+    // short, and cfg keeps the requested counts for any further attempt
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "IMapGenerator.h"
+
+// City-like maps from gradient noise: a lattice of streets whose course is
+// bent by a low-frequency warp field, parks and plazas where a second noise
+// field crosses a threshold, and buildings ('#') everywhere else. Clients and
+// stations sit on street cells drawn from a "downtown" density field.
+//
+// Every cell is a pure function of (seed, x, y), so the map is generated in
+// row tiles on several threads and stays identical for a given seed no
+// matter how the tiles are scheduled.
+class NoiseMapGenerator : public IMapGenerator {
+public:
+    explicit NoiseMapGenerator(int blockSize = 10, int streetWidth = 2, double parkThreshold = 0.3, int threads = 0);
+    void generate(Config& cfg, CounterRng& rng, std::vector<std::string>& grid,
+                  Vec2& basePos, std::vector<Vec2>& clients, std::vector<Vec2>& stations) override;
+    bool canRegenerate() const override { return true; }
+private:
+    int blockSize;
+    int streetWidth;
+    float parkThreshold;
+    int threads; // 0 = hardware concurrency
+};
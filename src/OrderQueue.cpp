@@ -0,0 +1,76 @@
+#include "OrderQueue.h"
+
+#include <algorithm>
+#include <cstdint>
+
+OrderQueue::OrderQueue(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    mask = size - 1;
+    slots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; ++i)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool OrderQueue::tryPush(const OrderRequest &order)
+{
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+        slot = &slots[pos & mask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            // the slot is free for this position; claim it
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // the consumer has not freed this slot yet: the ring is full
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+            pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+    slot->order = order;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    acceptedCount.fetch_add(1, std::memory_order_relaxed);
+    // the consumer may already have drained past this order, so the
+    // difference can be zero or negative; it never exceeds the capacity
+    const intptr_t behind = (intptr_t)(pos + 1 - dequeuePos.load(std::memory_order_relaxed));
+    if (behind <= 0)
+        return true;
+    const size_t depthNow = std::min((size_t)behind, mask + 1);
+    size_t seen = highWaterMark.load(std::memory_order_relaxed);
+    while (depthNow > seen && !highWaterMark.compare_exchange_weak(seen, depthNow, std::memory_order_relaxed))
+    {
+    }
+    return true;
+}
+
+bool OrderQueue::tryPop(OrderRequest &out)
+{
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot &slot = slots[pos & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        return false; // empty, or the producer holding this slot is mid-write
+    out = slot.order;
+    // hand the slot to the producer one lap ahead
+    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t OrderQueue::depth() const
+{
+    size_t head = dequeuePos.load(std::memory_order_relaxed);
+    size_t tail = enqueuePos.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A package request pushed from outside the simulation thread.
+struct OrderRequest {
+    int destX = 0;
+    int destY = 0;
+    int reward = 0;
+    int deadlineTicks = 0; // relative to the tick the order is drained on
+    long long submittedUs = 0; // orderClockUs() at submission; 0 = latency not tracked
+};
+
+// Monotonic clock for order latency, in microseconds.
+inline long long orderClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Bounded lock-free multi-producer / single-consumer ring buffer (Vyukov's
+// bounded queue with per-slot sequence numbers). Any number of threads may
+// call tryPush concurrently; only the simulation thread calls tryPop.
+//
+// Backpressure policy: the queue never blocks and never grows. When it is
+// full, tryPush returns false and counts the rejection; the producer decides
+// whether to retry, shed or slow down. The capacity should cover the orders
+// expected between two ticks.
+class OrderQueue {
+public:
+    explicit OrderQueue(size_t capacity); // rounded up to a power of two
+
+    OrderQueue(const OrderQueue&) = delete;
+    OrderQueue& operator=(const OrderQueue&) = delete;
+
+    bool tryPush(const OrderRequest& order); // any thread; false when full
+    bool tryPop(OrderRequest& out);          // consumer thread only
+
+    size_t capacity() const { return mask + 1; }
+    size_t depth() const;                    // approximate while producers run
+    size_t highWater() const { return highWaterMark.load(std::memory_order_relaxed); }
+    uint64_t accepted() const { return acceptedCount.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        OrderRequest order;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+    alignas(64) std::atomic<size_t> highWaterMark{0};
+    std::atomic<uint64_t> acceptedCount{0};
+    std::atomic<uint64_t> rejectedCount{0};
+};
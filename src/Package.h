@@ -2,14 +2,15 @@
 
 class Package {
 public:
-    Package(int id, int destX, int destY, int reward, int deadline)
-        : id(id), destX(destX), destY(destY), reward(reward), deadline(deadline), delivered(false), delivered_tick(-1) {}
+    Package(int id, int destX, int destY, int reward, int deadline, int createdTick = 0)
+        : id(id), destX(destX), destY(destY), reward(reward), deadline(deadline), created(createdTick), delivered(false), delivered_tick(-1) {}
 
     int getId() const { return id; }
     int getDestX() const { return destX; }
     int getDestY() const { return destY; }
     int getReward() const { return reward; }
     int getDeadline() const { return deadline; }
+    int getCreatedTick() const { return created; }
 
     bool isDelivered() const { return delivered; }
     void markDelivered(int tick) { delivered = true; delivered_tick = tick; }
@@ -20,6 +21,7 @@ private:
     int destX, destY;
     int reward;
     int deadline;
+    int created; // tick the package entered the waiting pool
     bool delivered;
     int delivered_tick;
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "PairScoring.h"
+#include "KpiLedger.h"
+
+namespace {
+
+// ceil(n / d) for n >= 0 and d >= 1. Vector units divide floating point but
+// not integers; the double quotient of int32 operands never rounds across an
+// integer, so truncating it is exact.
+inline int32_t ceilDiv(int32_t n, int32_t d)
+{
+    return (int32_t)(((double)n + (double)(d - 1)) / (double)d);
+}
+
+inline int32_t nonNegative(int32_t v)
+{
+    return v < 0 ? 0 : v;
+}
+
+} // namespace
+
+// Both the direct trip and the charger detour are evaluated for every slot
+// and selected with masks; sentinel -1 inputs
+// are clamped to 0 first and the lanes they belong to are masked out, so the
+// unselected arithmetic stays as small as the selected one.
+void scoreBatch(const ScoreBatch &b, int reward, int deadline, int currentTick, long long infeasible,
+                long long *out)
+{
+    const int32_t *__restrict speed = b.speed;
+    const int32_t *__restrict consumption = b.consumption;
+    const int32_t *__restrict cost = b.cost;
+    const int32_t *__restrict budget = b.budget;
+    const int32_t *__restrict capacity = b.capacity;
+    const int32_t *__restrict chargeRate = b.chargeRate;
+    const int32_t *__restrict here = b.here;
+    const int32_t *__restrict dist = b.dist;
+    const int32_t *__restrict outBound = b.outBound;
+    const int32_t *__restrict after = b.after;
+    long long *__restrict cell = out;
+
+    for (int j = 0; j < b.count; ++j)
+    {
+        const int32_t s = speed[j];
+        const int32_t e = consumption[j];
+        const int32_t d = nonNegative(dist[j]);
+        const int32_t h = nonNegative(here[j]);
+
+        const int32_t needAfter = ceilDiv(after[j], s) * e;
+        // not even a full battery would do
+        const int fits = capacity[j] >= ceilDiv(outBound[j], s) * e + needAfter;
+
+        const int32_t etaDirect = ceilDiv(d, s);
+        const int direct = budget[j] >= etaDirect * e + needAfter;
+
+        // Plan a stop at the charger nearest the courier. The leg from there
+        // is bounded by going back through the courier's position; movement
+        // (legTarget) takes the actual route.
+        const int32_t ticksHere = ceilDiv(h, s);
+        const int32_t ticksVia = ceilDiv(h + d, s);
+        const int32_t needHere = ticksHere * e;
+        const int32_t needVia = ticksVia * e + needAfter;
+        const int viaOk = (here[j] >= 0) & (budget[j] >= needHere) & (capacity[j] >= needVia);
+        const int32_t deficit = nonNegative(needVia - (budget[j] - needHere));
+        const int32_t etaVia = ticksHere + ceilDiv(deficit, chargeRate[j]) + ticksVia;
+
+        // blended with masks: a select would let the compiler move the detour
+        // arithmetic under a branch, which stops the loop vectorising
+        const int32_t useDirect = -direct, useVia = -((direct ^ 1) & viaOk);
+        const int32_t eta = (etaDirect & useDirect) | (etaVia & useVia);
+        const int32_t lateness = nonNegative(currentTick + eta - deadline);
+        const int32_t score = reward - eta * cost[j] - lateness * KpiLedger::latePenalty;
+
+        const long long feasible = -(long long)((dist[j] >= 0) & fits & (direct | viaOk) & (score > -1000000));
+        cell[j] = (-(long long)score & feasible) | (infeasible & ~feasible);
+    }
+}
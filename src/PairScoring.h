@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Batched pair scoring for the dispatch cost matrix: one package against a
+// run of courier slots, held as parallel arrays. The distances come in
+// precomputed (Simulation::pairInputs; they need rule checks and path
+// queries); everything after that - ETA, battery feasibility, the charger
+// detour, lateness and score - is a flat branch-free loop that the compiler
+// vectorises. Infeasible pairs are masked to `infeasible` rather than
+// branched around. The score is the one computePriority gives.
+
+struct ScoreBatch {
+    int count = 0;
+    // per slot, from its courier and the rule of the courier's type
+    const int32_t* speed = nullptr;
+    const int32_t* consumption = nullptr;
+    const int32_t* cost = nullptr;       // per tick
+    const int32_t* budget = nullptr;     // battery above the rule's reserve (may be negative)
+    const int32_t* capacity = nullptr;   // max battery less the reserve
+    const int32_t* chargeRate = nullptr; // per tick on a charger
+    const int32_t* here = nullptr;       // courier -> its nearest charger (-1 = none)
+    // per pair, for this package
+    const int32_t* dist = nullptr;     // courier -> destination (-1 = already ruled out)
+    const int32_t* outBound = nullptr; // Manhattan courier -> destination
+    const int32_t* after = nullptr;    // destination -> its nearest charger
+};
+
+// out[j] = the pair cost of slot j: -score, or `infeasible`
+void scoreBatch(const ScoreBatch& b, int reward, int deadline, int currentTick, long long infeasible,
+                long long* out);
@@ -1,54 +1,122 @@
 #include "ProceduralMapGenerator.h"
 #include "Simulation.h" // for Config
 #include <random>
+#include <numeric>
+
+namespace {
+
+// Union-find over cell indices (path halving + union by size)
+struct DisjointSets {
+    std::vector<int> parent;
+    std::vector<int> size;
+
+    explicit DisjointSets(int n) : parent(n), size(n, 1)
+    {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    int find(int a)
+    {
+        while (parent[a] != a)
+        {
+            parent[a] = parent[parent[a]];
+            a = parent[a];
+        }
+        return a;
+    }
+
+    void unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return;
+        if (size[a] < size[b])
+            std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+    }
+};
+
+} // namespace
 
 ProceduralMapGenerator::ProceduralMapGenerator(double wallProbability)
     : wallProb(wallProbability) {}
 
-void ProceduralMapGenerator::generate(Config& cfg, std::mt19937& rng, std::vector<std::string>& grid,
+void ProceduralMapGenerator::generate(Config& cfg, CounterRng& rng, std::vector<std::string>& grid,
                                       Vec2& basePos, std::vector<Vec2>& clients, std::vector<Vec2>& stations) {
-    grid.assign(cfg.rows, std::string(cfg.cols, '.'));
+    const int rows = cfg.rows;
+    const int cols = cfg.cols;
+    grid.assign(rows, std::string(cols, '.'));
     // Place base in center (x=col, y=row)
-    basePos = {cfg.rows/2, cfg.cols/2};
+    basePos = {rows/2, cols/2};
     grid[basePos.x][basePos.y] = 'B';
 
-    // random placements
-    std::uniform_int_distribution<int> rx(0, cfg.rows-1);
-    std::uniform_int_distribution<int> ry(0, cfg.cols-1);
+    // Sample clients and stations from the list of free cells with a partial
+    // Fisher-Yates shuffle: every draw hits a free cell, however full the map.
+    std::vector<int> freeCells;
+    freeCells.reserve((size_t)rows * cols);
+    for (int i = 0; i < rows * cols; ++i)
+        if (i != basePos.x * cols + basePos.y)
+            freeCells.push_back(i);
+    size_t drawn = 0;
+    auto drawFreeCell = [&]() {
+        std::uniform_int_distribution<size_t> pick(drawn, freeCells.size() - 1);
+        std::swap(freeCells[drawn], freeCells[pick(rng)]);
+        int idx = freeCells[drawn++];
+        return Vec2{idx / cols, idx % cols};
+    };
 
     // place clients
     clients.clear();
-    for (int i = 0; i < cfg.clientsCount; ++i) {
-        while (true) {
-            int x = rx(rng);
-            int y = ry(rng);
-            if (grid[x][y] == '.') {
-                grid[x][y] = 'D';
-                clients.push_back({x,y});
-                break;
-            }
-        }
+    for (int i = 0; i < cfg.clientsCount && drawn < freeCells.size(); ++i) {
+        Vec2 p = drawFreeCell();
+        grid[p.x][p.y] = 'D';
+        clients.push_back(p);
     }
 
     // place stations
     stations.clear();
-    for (int i = 0; i < cfg.maxStations; ++i) {
-        while (true) {
-            int x = rx(rng);
-            int y = ry(rng);
-            if (grid[x][y] == '.') {
-                grid[x][y] = 'S';
-                stations.push_back({x,y});
-                break;
-            }
-        }
+    for (int i = 0; i < cfg.maxStations && drawn < freeCells.size(); ++i) {
+        Vec2 p = drawFreeCell();
+        grid[p.x][p.y] = 'S';
+        stations.push_back(p);
     }
 
-    // add some walls
+    // Add some walls, tracking connected components as we go: each open cell
+    // joins its already-decided upper and left neighbours.
+    DisjointSets sets(rows * cols);
     std::uniform_real_distribution<> frac(0.0, 1.0);
-    for (int x = 0; x < cfg.rows; ++x) {
-        for (int y = 0; y < cfg.cols; ++y) {
-            if (grid[x][y] == '.' && frac(rng) < wallProb) grid[x][y] = '#';
+    for (int x = 0; x < rows; ++x) {
+        for (int y = 0; y < cols; ++y) {
+            if (grid[x][y] == '.' && frac(rng) < wallProb) {
+                grid[x][y] = '#';
+                continue;
+            }
+            int idx = x * cols + y;
+            if (x > 0 && grid[x-1][y] != '#') sets.unite(idx, idx - cols);
+            if (y > 0 && grid[x][y-1] != '#') sets.unite(idx, idx - 1);
         }
     }
+
+    // Carve a corridor from every cut-off client/station towards the base,
+    // stopping as soon as it touches the base's component.
+    auto carveToBase = [&](Vec2 from) {
+        Vec2 cur = from;
+        while (sets.find(cur.x * cols + cur.y) != sets.find(basePos.x * cols + basePos.y)) {
+            if (cur.x != basePos.x) cur.x += (basePos.x > cur.x) ? 1 : -1;
+            else cur.y += (basePos.y > cur.y) ? 1 : -1;
+            int idx = cur.x * cols + cur.y;
+            if (grid[cur.x][cur.y] == '#') grid[cur.x][cur.y] = '.';
+            const int dr[4] = {1, -1, 0, 0};
+            const int dc[4] = {0, 0, 1, -1};
+            for (int k = 0; k < 4; ++k) {
+                int nr = cur.x + dr[k], nc = cur.y + dc[k];
+                if (nr < 0 || nc < 0 || nr >= rows || nc >= cols || grid[nr][nc] == '#') continue;
+                sets.unite(idx, nr * cols + nc);
+            }
+        }
+    };
+    for (const Vec2& c : clients) carveToBase(c);
+    for (const Vec2& s : stations) carveToBase(s);
 }
@@ -5,8 +5,11 @@
 class ProceduralMapGenerator : public IMapGenerator {
 public:
     explicit ProceduralMapGenerator(double wallProbability = 0.08);
-    void generate(Config& cfg, std::mt19937& rng, std::vector<std::string>& grid,
+    void generate(Config& cfg, CounterRng& rng, std::vector<std::string>& grid,
                   Vec2& basePos, std::vector<Vec2>& clients, std::vector<Vec2>& stations) override;
+    // walls are placed with union-find and cut-off cells are carved free
+    bool guaranteesConnectivity() const override { return true; }
+    bool canRegenerate() const override { return true; }
 private:
     double wallProb;
 };
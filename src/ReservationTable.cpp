@@ -0,0 +1,127 @@
+#include "ReservationTable.h"
+
+size_t ReservationTable::find(uint64_t key) const
+{
+    const size_t mask = slots.size() - 1;
+    for (size_t i = home(key);; i = (i + 1) & mask)
+    {
+        if (slots[i].agent == none)
+            return slots.size();
+        if (slots[i].key == key)
+            return i;
+    }
+}
+
+int ReservationTable::holder(int cell, int tick) const
+{
+    size_t i = find(keyOf(cell, tick));
+    if (i != slots.size())
+        return slots[i].agent;
+    if ((size_t)cell < parkedAgent.size() && parkedAgent[cell] != none && parkedFrom[cell] <= tick)
+        return parkedAgent[cell];
+    return none;
+}
+
+void ReservationTable::insert(uint64_t key, int agent)
+{
+    const size_t mask = slots.size() - 1;
+    size_t i = home(key);
+    while (slots[i].agent != none)
+        i = (i + 1) & mask;
+    slots[i].key = key;
+    slots[i].agent = agent;
+    ++count;
+}
+
+void ReservationTable::grow()
+{
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot{});
+    count = 0;
+    for (const Slot &s : old)
+        if (s.agent != none)
+            insert(s.key, s.agent);
+}
+
+bool ReservationTable::reserve(int cell, int tick, int agent)
+{
+    const uint64_t key = keyOf(cell, tick);
+    size_t i = find(key);
+    if (i != slots.size())
+        return slots[i].agent == agent;
+    const int parked = holder(cell, tick);
+    if (parked != none && parked != agent)
+        return false;
+    if ((count + 1) * 2 > slots.size())
+        grow();
+    insert(key, agent);
+    return true;
+}
+
+void ReservationTable::release(int cell, int tick, int agent)
+{
+    size_t hole = find(keyOf(cell, tick));
+    if (hole == slots.size() || slots[hole].agent != agent)
+        return;
+    // backward-shift deletion: pull up every later entry of the chain whose
+    // home does not lie cyclically in (hole, j]
+    const size_t mask = slots.size() - 1;
+    for (size_t j = (hole + 1) & mask; slots[j].agent != none; j = (j + 1) & mask)
+    {
+        const size_t h = home(slots[j].key);
+        const bool stays = hole < j ? (hole < h && h <= j) : (hole < h || h <= j);
+        if (!stays)
+        {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+    }
+    slots[hole] = Slot{};
+    --count;
+}
+
+void ReservationTable::expireBefore(int tick)
+{
+    std::vector<Slot> old;
+    old.swap(slots);
+    size_t size = 64;
+    size_t live = 0;
+    for (const Slot &s : old)
+        live += s.agent != none && tickOf(s.key) >= tick;
+    while (live * 2 > size)
+        size *= 2;
+    slots.assign(size, Slot{});
+    count = 0;
+    for (const Slot &s : old)
+        if (s.agent != none && tickOf(s.key) >= tick)
+            insert(s.key, s.agent);
+}
+
+void ReservationTable::clear()
+{
+    slots.assign(64, Slot{});
+    count = 0;
+    parkedAgent.clear();
+    parkedFrom.clear();
+}
+
+bool ReservationTable::park(int cell, int fromTick, int agent)
+{
+    if ((size_t)cell >= parkedAgent.size())
+    {
+        parkedAgent.resize(cell + 1, none);
+        parkedFrom.resize(cell + 1, 0);
+    }
+    if (parkedAgent[cell] != none && parkedAgent[cell] != agent)
+        return false;
+    parkedAgent[cell] = agent;
+    parkedFrom[cell] = fromTick;
+    return true;
+}
+
+void ReservationTable::unpark(int cell, int agent)
+{
+    if ((size_t)cell < parkedAgent.size() && parkedAgent[cell] == agent)
+        parkedAgent[cell] = none;
+}
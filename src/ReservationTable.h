@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Space-time reservations for cooperative pathfinding: which agent holds a
+// (cell, tick) slot. Open addressing with linear probing over 16-byte slots;
+// erase shifts later entries back instead of leaving tombstones, so probe
+// chains stay short however long the run. Entries for past ticks are dropped
+// in bulk by expireBefore. An agent that has run out of plan parks on its
+// last cell: it holds the cell from a tick on until it unparks.
+class ReservationTable {
+public:
+    static constexpr int none = -1;
+
+    ReservationTable() { slots.assign(64, Slot{}); }
+
+    int holder(int cell, int tick) const;
+    // false (and no change) if another agent already holds the slot
+    bool reserve(int cell, int tick, int agent);
+    // frees the slot if `agent` holds it
+    void release(int cell, int tick, int agent);
+    void expireBefore(int tick);
+    void clear();
+
+    // open-ended hold on a cell from `fromTick` on; false if another agent parks there
+    bool park(int cell, int fromTick, int agent);
+    void unpark(int cell, int agent);
+
+    size_t size() const { return count; }
+    size_t memoryBytes() const { return slots.size() * sizeof(Slot) + parkedAgent.size() * 2 * sizeof(int32_t); }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        int32_t agent = none; // none = empty
+    };
+    std::vector<Slot> slots; // power-of-two size, at most half full
+    size_t count = 0;
+    std::vector<int32_t> parkedAgent; // by cell, grown on demand
+    std::vector<int32_t> parkedFrom;
+
+    static uint64_t keyOf(int cell, int tick) { return (uint64_t)(uint32_t)tick << 32 | (uint32_t)cell; }
+    static int tickOf(uint64_t key) { return (int)(uint32_t)(key >> 32); }
+    size_t home(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (slots.size() - 1);
+    }
+    size_t find(uint64_t key) const; // slot index, or slots.size()
+    void insert(uint64_t key, int agent);
+    void grow();
+};
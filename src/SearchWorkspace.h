@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Reusable state for breadth-first grid searches. Visited marks carry the
+// number of the search that set them, so begin() is O(1) instead of a
+// rows * cols fill, and the FIFO is a plain buffer sized once for the grid:
+// each cell enters it at most once per search, so it never wraps.
+class SearchWorkspace {
+public:
+    // starts a search over `cells` cells; allocates only for a bigger grid
+    void begin(size_t cells)
+    {
+        if (stamp.size() < cells)
+        {
+            stamp.assign(cells, 0);
+            parentOf.resize(cells);
+            queue.resize(cells);
+            search = 0;
+        }
+        if (++search == 0) // wrapped: stale marks could look current
+        {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            search = 1;
+        }
+        head = tail = 0;
+    }
+
+    bool visited(int cell) const { return stamp[cell] == search; }
+    // marks `cell` reached from `parent` (-1 for a source) and queues it
+    void push(int cell, int parent)
+    {
+        stamp[cell] = search;
+        parentOf[cell] = parent;
+        queue[tail++] = cell;
+    }
+    bool empty() const { return head == tail; }
+    int pop() { return queue[head++]; }
+    int parent(int cell) const { return parentOf[cell]; } // valid once visited
+
+private:
+    std::vector<uint32_t> stamp;
+    std::vector<int> parentOf;
+    std::vector<int> queue;
+    uint32_t search = 0;
+    size_t head = 0, tail = 0;
+};
@@ -0,0 +1,144 @@
+#include "SharedState.h"
+#include "Errors.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static size_t segmentBytes(uint32_t capacity)
+{
+    return sizeof(SharedStateHeader) + sizeof(SharedFrame) + (size_t)capacity * sizeof(SharedCourier);
+}
+
+static SharedFrame *frameIn(void *base)
+{
+    return reinterpret_cast<SharedFrame *>(static_cast<char *>(base) + sizeof(SharedStateHeader));
+}
+
+static SharedCourier *couriersIn(void *base)
+{
+    return reinterpret_cast<SharedCourier *>(static_cast<char *>(base) + sizeof(SharedStateHeader) +
+                                             sizeof(SharedFrame));
+}
+
+StatePublisher::StatePublisher(const std::string &segment, int courierCapacity) : name(segment)
+{
+    const uint32_t capacity = (uint32_t)std::max(0, courierCapacity);
+    bytes = segmentBytes(capacity);
+    // a segment left behind by a crashed run may have another size
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        throw FileOpenError("Could not create shared state '" + name + "': " + std::strerror(errno));
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        const int err = errno;
+        close(fd);
+        shm_unlink(name.c_str());
+        throw FileOpenError("Could not size shared state '" + name + "': " + std::strerror(err));
+    }
+    base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        base = nullptr;
+        shm_unlink(name.c_str());
+        throw FileOpenError("Could not map shared state '" + name + "'");
+    }
+    // fresh pages are zero: sequence 0 means nothing published yet
+    header = new (base) SharedStateHeader;
+    header->capacity = capacity;
+    header->version = SharedStateHeader::currentVersion;
+    header->live.store(1, std::memory_order_relaxed);
+    header->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedStateHeader::expectedMagic;
+    couriers.reserve(capacity);
+}
+
+StatePublisher::~StatePublisher()
+{
+    if (!base)
+        return;
+    header->live.store(0, std::memory_order_release);
+    munmap(base, bytes);
+    shm_unlink(name.c_str());
+}
+
+void StatePublisher::publish()
+{
+    const size_t n = std::min(couriers.size(), (size_t)header->capacity);
+    frame.courierCount = (int32_t)n;
+    const uint64_t seq = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // odd before any payload store
+    std::memcpy(frameIn(base), &frame, sizeof(SharedFrame));
+    if (n)
+        std::memcpy(couriersIn(base), couriers.data(), n * sizeof(SharedCourier));
+    header->sequence.store(seq + 2, std::memory_order_release);
+    ++frames;
+}
+
+StateReader::StateReader(const std::string &segment)
+{
+    const int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw FileOpenError("Could not open shared state '" + segment + "': " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < segmentBytes(0))
+    {
+        close(fd);
+        throw FileOpenError("Shared state '" + segment + "' is not initialised");
+    }
+    bytes = (size_t)st.st_size;
+    void *p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw FileOpenError("Could not map shared state '" + segment + "'");
+    base = p;
+    header = static_cast<const SharedStateHeader *>(base);
+    if (header->magic != SharedStateHeader::expectedMagic ||
+        header->version != SharedStateHeader::currentVersion || segmentBytes(header->capacity) > bytes)
+    {
+        munmap(p, bytes);
+        throw FileOpenError("Shared state '" + segment + "' has an unknown layout");
+    }
+}
+
+StateReader::~StateReader()
+{
+    munmap(const_cast<void *>(base), bytes);
+}
+
+bool StateReader::read(SharedFrame &frame, std::vector<SharedCourier> &out, int maxTries)
+{
+    void *seg = const_cast<void *>(base); // only read through
+    for (int attempt = 0; attempt < maxTries; ++attempt)
+    {
+        const uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false;
+        if (before & 1)
+        {
+            ++tornReads;
+            std::this_thread::yield();
+            continue;
+        }
+        std::memcpy(&frame, frameIn(seg), sizeof(SharedFrame));
+        const size_t n = (size_t)std::clamp<int32_t>(frame.courierCount, 0, (int32_t)header->capacity);
+        out.resize(n);
+        if (n)
+            std::memcpy(out.data(), couriersIn(seg), n * sizeof(SharedCourier));
+        std::atomic_thread_fence(std::memory_order_acquire); // payload loads before the re-check
+        if (header->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+        ++tornReads;
+    }
+    return false;
+}
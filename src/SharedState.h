@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Live run state in a POSIX shared-memory segment (SHARED_STATE: /name) for
+// viewers and monitors in other processes. The simulation overwrites one
+// frame after every tick under a seqlock: the sequence number is odd while
+// the frame is being written, and a reader that sees the same even number
+// before and after its copy has a consistent frame. Readers never block the
+// writer and never write to the segment.
+//
+// Segment layout: SharedStateHeader, SharedFrame, then `capacity`
+// SharedCourier records (only frame.courierCount of them are meaningful).
+
+struct SharedCourier {
+    int32_t x, y;
+    int32_t battery, maxBattery;
+    uint8_t kind;     // CourierKind
+    uint8_t dead;
+    uint8_t carrying; // packages on board
+    uint8_t pad;
+};
+
+struct SharedFrame {
+    int32_t tick;
+    int32_t rows, cols;
+    int32_t waiting; // packages in the pool
+    int32_t spawned, delivered, deliveredLate, deadAgents;
+    int32_t activeCouriers, carryingCouriers;
+    int64_t profit; // provisional, as in the telemetry
+    int32_t courierCount;
+    int32_t pad;
+};
+
+struct SharedStateHeader {
+    static constexpr uint32_t expectedMagic = 0x48495645; // "HIVE"
+    static constexpr uint32_t currentVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; // courier records after the frame
+    std::atomic<uint32_t> live; // cleared when the publisher closes
+    std::atomic<uint64_t> sequence;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock must work across processes");
+
+// Writer side: creates (or replaces) the segment and publishes frames.
+// Throws FileOpenError when the segment cannot be created.
+class StatePublisher {
+public:
+    StatePublisher(const std::string& name, int courierCapacity);
+    ~StatePublisher(); // marks the segment closed and unlinks the name
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    // fill these, then publish(); couriers beyond the capacity are dropped
+    SharedFrame frame{};
+    std::vector<SharedCourier> couriers;
+    void publish();
+
+    long long published() const { return frames; }
+
+private:
+    std::string name;
+    void* base = nullptr;
+    size_t bytes = 0;
+    SharedStateHeader* header = nullptr;
+    long long frames = 0;
+};
+
+// Reader side: maps an existing segment read-only.
+class StateReader {
+public:
+    explicit StateReader(const std::string& name); // throws FileOpenError
+    ~StateReader();
+
+    StateReader(const StateReader&) = delete;
+    StateReader& operator=(const StateReader&) = delete;
+
+    // Copies the latest consistent frame; false if none has been published
+    // yet or the writer kept overwriting it for `maxTries` attempts.
+    bool read(SharedFrame& frame, std::vector<SharedCourier>& couriers, int maxTries = 1000);
+    bool live() const { return header->live.load(std::memory_order_acquire) != 0; }
+    uint64_t sequence() const { return header->sequence.load(std::memory_order_acquire); }
+    long long retries() const { return tornReads; } // copies discarded as torn
+
+private:
+    const void* base = nullptr;
+    size_t bytes = 0;
+    const SharedStateHeader* header = nullptr;
+    long long tornReads = 0;
+};
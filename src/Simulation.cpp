@@ -14,11 +14,14 @@
 #include <stdexcept>
 #include <exception>
 #include <cstdlib>
+#include <csignal>
 
 #include "Errors.h"
 #include "IMapGenerator.h"
 #include "FileMapLoader.h"
-#include "ProceduralMapGenerator.h"
+#include "DispatchService.h"
+#include "Assignment.h"
+#include "PairScoring.h"
 
 void Simulation::render()
 {
@@ -26,7 +29,7 @@ void Simulation::render()
     std::cout << "\x1B[2J\x1B[H";
 
     // copy base grid
-    std::vector<std::string> view = grid;
+    std::vector<std::string> view = map->grid;
 
     // overlay couriers
     // std::map<std::pair<int,int>, int> countAt;
@@ -35,7 +38,7 @@ void Simulation::render()
         if (c->isDead())
             continue;
         Vec2 p = c->getPos();
-        if (p.x < 0 || p.x >= cfg.rows || p.y < 0 || p.y >= cfg.cols || (p.x == basePos.x && p.y == basePos.y))
+        if (p.x < 0 || p.x >= cfg.rows || p.y < 0 || p.y >= cfg.cols || (p.x == map->basePos.x && p.y == map->basePos.y))
             continue;
         // countAt[{p.x,p.y}]++;
         char ch = '?';
@@ -77,57 +80,102 @@ void Simulation::render()
     }
 
     // stats
-    int delivered = 0;
-    int delayed = 0;
-    for (const auto &p : packages)
-    {
-        if (p->isDelivered())
-        {
-            ++delivered;
-            if (delivered == cfg.totalPackages)
-            {
-                setAllDelivered();
-            }
-            if (p->deliveredAt() > p->getDeadline())
-                ++delayed;
-        }
-    }
     int waiting = (int)packagePool.size();
 
-    int provisionalProfit = 0;
-    for (const auto &p : packages)
+    std::cout << "Tick: " << currentTick << "/" << cfg.maxTicks << "    ";
+    std::cout << "Delivered: " << ledger.delivered << "    Waiting: " << waiting << "    ";
+    std::cout << "Active: " << ledger.activeCouriers << " (carrying=" << ledger.carryingCouriers << ")    ";
+    std::cout << "Profit (est): " << ledger.provisionalProfit() << "    ";
+    std::cout << "Total agents spawned: " << couriers.size() << "\n";
+
+    std::cout << std::flush;
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.displayDelayMs));
+}
+
+void Simulation::openFrameExport()
+{
+    if (cfg.frameDir.empty())
+        return;
+    frames = std::make_unique<FrameExporter>(cfg.frameDir, cfg.rows, cfg.cols, cfg.frameScale,
+                                             (size_t)std::max(1, cfg.frameBuffer));
+}
+
+static void onTraceSignal(int)
+{
+    if (TraceRecorder *rec = TraceRecorder::active())
+        rec->requestExport();
+}
+
+void Simulation::openTrace()
+{
+    if (cfg.traceFile.empty())
+        return;
+    tracer = std::make_unique<TraceRecorder>((size_t)std::max(1, cfg.traceBuffer));
+    tracer->nameThisThread("simulation");
+    std::signal(SIGUSR1, onTraceSignal);
+}
+
+void Simulation::exportTrace()
+{
+    if (!tracer->exportJson(cfg.traceFile))
+        std::cerr << "Could not write trace file: " << cfg.traceFile << "\n";
+}
+
+void Simulation::openSharedState()
+{
+    if (cfg.sharedState.empty())
+        return;
+    // couriers are never removed, so the caps bound the courier list
+    sharedState = std::make_unique<StatePublisher>(cfg.sharedState, cfg.drones + cfg.robots + cfg.scooters);
+}
+
+void Simulation::publishState()
+{
+    if (!sharedState)
+        return;
+    SharedFrame &f = sharedState->frame;
+    f.tick = currentTick;
+    f.rows = cfg.rows;
+    f.cols = cfg.cols;
+    f.waiting = (int32_t)packagePool.size();
+    f.spawned = ledger.spawned;
+    f.delivered = ledger.delivered;
+    f.deliveredLate = ledger.deliveredLate;
+    f.deadAgents = ledger.deadAgents;
+    f.activeCouriers = ledger.activeCouriers;
+    f.carryingCouriers = ledger.carryingCouriers;
+    f.profit = ledger.provisionalProfit();
+    std::vector<SharedCourier> &out = sharedState->couriers;
+    out.clear();
+    for (const auto &c : couriers)
     {
-        if (p->isDelivered())
-        {
-            provisionalProfit += p->getReward();
-            if (p->deliveredAt() > p->getDeadline())
-                provisionalProfit -= 50;
-        }
+        const Vec2 p = c->getPos();
+        out.push_back({p.x, p.y, c->getBattery(), c->getMaxBattery(), (uint8_t)c->kind(), (uint8_t)c->isDead(),
+                       (uint8_t)std::min<size_t>(c->getPackages().size(), 255), 0});
     }
-    provisionalProfit -= operatingCostTotal;
-    provisionalProfit -= deadAgents * 500;
+    sharedState->publish();
+}
 
-    int activeAgents = 0;
-    int carryingAgents = 0;
+void Simulation::captureFrame()
+{
+    lastFrameTick = currentTick;
+    uint8_t *cells = frames->acquire();
+    if (!cells)
+        return; // writer behind: counted as dropped
+    for (int x = 0; x < cfg.rows; ++x)
+        for (int y = 0; y < cfg.cols; ++y)
+            cells[x * cfg.cols + y] = FrameExporter::colorOf(map->grid[x][y]);
+    // couriers over the map, except on the base (as in render)
+    static const FrameExporter::Color courierColor[3] = {FrameExporter::Drone, FrameExporter::Robot,
+                                                         FrameExporter::Scooter};
     for (const auto &c : couriers)
     {
-        if (c->isDead())
+        const Vec2 p = c->getPos();
+        if (c->isDead() || (p.x == map->basePos.x && p.y == map->basePos.y))
             continue;
-        bool isActive = !c->getPackages().empty() || (c->getPos().x != basePos.x || c->getPos().y != basePos.y);
-        if (isActive)
-            ++activeAgents;
-        if (!c->getPackages().empty())
-            ++carryingAgents;
+        cells[p.x * cfg.cols + p.y] = courierColor[(int)c->kind()];
     }
-
-    std::cout << "Tick: " << currentTick << "/" << cfg.maxTicks << "    ";
-    std::cout << "Delivered: " << delivered << "    Waiting: " << waiting << "    ";
-    std::cout << "Active: " << activeAgents << " (carrying=" << carryingAgents << ")    ";
-    std::cout << "Profit (est): " << provisionalProfit << "    ";
-    std::cout << "Total agents spawned: " << couriers.size() << "\n";
-
-    std::cout << std::flush;
-    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.displayDelayMs));
+    frames->publish(currentTick);
 }
 bool Simulation::isAllDelivered()
 {
@@ -169,10 +217,12 @@ Simulation::Simulation(const std::string &configPath)
     singletonInstance = this;
 
     std::random_device rd;
-    rng.seed(rd());
+    rngSeed = (uint64_t)rd() << 32 | rd();
 
     // Defer choosing map generator until after config is loaded.
     mapGenerator = nullptr;
+    compileRules();
+    orders = std::make_unique<OrderQueue>(cfg.orderQueueCapacity);
 }
 
 Simulation::~Simulation()
@@ -186,7 +236,7 @@ std::vector<std::unique_ptr<Package>>& Simulation::getPackagesForTest() { return
 std::vector<Package*>& Simulation::getPackagePoolForTest() { return packagePool; }
 std::vector<std::unique_ptr<Courier>>& Simulation::getCouriersForTest() { return couriers; }
 void Simulation::setCurrentTickForTest(int t) { currentTick = t; }
-void Simulation::seedRngForTest(unsigned s) { rng.seed(s); }
+void Simulation::seedRngForTest(unsigned s) { rngSeed = s; }
 #endif
 
 void Simulation::loadConfig()
@@ -231,6 +281,115 @@ void Simulation::loadConfig()
             iss >> cfg.spawnFrequency;
         else if (key == "DISPLAY_DELAY_MS:")
             iss >> cfg.displayDelayMs;
+        else if (key == "LOOKAHEAD_HORIZON:")
+            iss >> cfg.lookaheadHorizon;
+        else if (key == "LOOKAHEAD_CANDIDATES:")
+            iss >> cfg.lookaheadCandidates;
+        else if (key == "LOOKAHEAD_BUDGET_US:")
+            iss >> cfg.lookaheadBudgetUs;
+        else if (key == "LOOKAHEAD_THREADS:")
+            iss >> cfg.lookaheadThreads;
+        else if (key == "PLANNER_CACHE_MB:")
+            iss >> cfg.plannerCacheMb;
+        else if (key == "TELEMETRY_FILE:")
+            iss >> cfg.telemetryFile;
+        else if (key == "TELEMETRY_FORMAT:")
+            iss >> cfg.telemetryFormat;
+        else if (key == "TELEMETRY_INTERVAL:")
+            iss >> cfg.telemetryInterval;
+        else if (key == "SNAPSHOT_FILE:")
+            iss >> cfg.snapshotFile;
+        else if (key == "SNAPSHOT_INTERVAL:")
+            iss >> cfg.snapshotInterval;
+        else if (key == "RESUME_SNAPSHOT:")
+            iss >> cfg.resumeSnapshot;
+        else if (key == "MAP_GENERATOR:")
+        {
+            std::string kind;
+            iss >> kind;
+            if (auto gen = makeMapGenerator(kind))
+                mapGenerator = std::move(gen);
+            else
+                std::cerr << "Unknown MAP_GENERATOR '" << kind << "', keeping the default\n";
+        }
+        else if (key == "SEED:")
+        {
+            iss >> cfg.seed;
+            if (cfg.seed >= 0)
+                rngSeed = (uint64_t)cfg.seed;
+        }
+        else if (key == "REPLICA:")
+        {
+            iss >> cfg.replica;
+            cfg.replica = std::max(0, cfg.replica);
+        }
+        else if (key == "ENGINE:")
+        {
+            std::string engine;
+            iss >> engine;
+            if (engine == "EVENT" || engine == "TICK")
+                cfg.eventEngine = engine == "EVENT";
+            else
+                std::cerr << "Unknown ENGINE '" << engine << "', keeping the tick engine\n";
+        }
+        else if (key == "ORDER_QUEUE_CAPACITY:")
+        {
+            iss >> cfg.orderQueueCapacity;
+            orders = std::make_unique<OrderQueue>(std::max(1, cfg.orderQueueCapacity));
+        }
+        else if (key == "SERVICE_SOCKET:")
+            iss >> cfg.serviceSocket;
+        else if (key == "SERVICE_TICK_MS:")
+            iss >> cfg.serviceTickMs;
+        else if (key == "ROAD_CAPACITY:")
+        {
+            iss >> cfg.roadCapacity;
+            if (cfg.roadCapacity > 1)
+            {
+                std::cerr << "ROAD_CAPACITY above 1 is not supported, using 1\n";
+                cfg.roadCapacity = 1;
+            }
+        }
+        else if (key == "WHCA_WINDOW:")
+            iss >> cfg.whcaWindow;
+        else if (key == "DISPATCH_BUDGET_US:")
+            iss >> cfg.dispatchBudgetUs;
+        else if (key == "FRAME_DIR:")
+            iss >> cfg.frameDir;
+        else if (key == "FRAME_INTERVAL:")
+            iss >> cfg.frameInterval;
+        else if (key == "FRAME_SCALE:")
+            iss >> cfg.frameScale;
+        else if (key == "FRAME_BUFFER:")
+            iss >> cfg.frameBuffer;
+        else if (key == "TRACE_FILE:")
+            iss >> cfg.traceFile;
+        else if (key == "TRACE_BUFFER:")
+            iss >> cfg.traceBuffer;
+        else if (key == "REPORT_JSON:")
+            iss >> cfg.reportJson;
+        else if (key == "SHARED_STATE:")
+            iss >> cfg.sharedState;
+        else if (key == "GROUND_ORACLE:")
+        {
+            std::string oracle;
+            iss >> oracle;
+            if (oracle == "CH" || oracle == "DSTAR")
+                cfg.chGroundOracle = oracle == "CH";
+            else
+                std::cerr << "Unknown GROUND_ORACLE '" << oracle << "', keeping D* Lite planners\n";
+        }
+        else if (key == "HEADLESS:")
+        {
+            int flag = 0;
+            iss >> flag;
+            cfg.headless = flag != 0;
+        }
+        else if (key == "RULE:")
+        {
+            if (!cfg.rules.parse(iss))
+                std::cerr << "Ignoring malformed rule: " << line << "\n";
+        }
         else if (key == "MAP_FILE:")
         {
             std::string mfile;
@@ -242,6 +401,7 @@ void Simulation::loadConfig()
             }
         }
     }
+    compileRules();
     // try
     // {
 
@@ -260,41 +420,40 @@ void Simulation::setMapGenerator(std::unique_ptr<IMapGenerator> gen)
 
 bool Simulation::validateMap() const
 {
+    if (!map)
+        return false;
     // Ensure base is inside grid
-    if (basePos.x < 0 || basePos.x >= cfg.rows || basePos.y < 0 || basePos.y >= cfg.cols)
+    if (map->basePos.x < 0 || map->basePos.x >= cfg.rows || map->basePos.y < 0 || map->basePos.y >= cfg.cols)
         return false;
-    std::vector<int> visited(cfg.rows * cfg.cols, 0);
-    std::queue<Vec2> q;
-    q.push(basePos);
-    visited[basePos.x * cfg.cols + basePos.y] = 1;
+    search.begin((size_t)cfg.rows * cfg.cols);
+    search.push(map->basePos.x * cfg.cols + map->basePos.y, -1);
     const int dr[4] = {1, -1, 0, 0};
     const int dc[4] = {0, 0, 1, -1};
-    while (!q.empty())
+    while (!search.empty())
     {
-        Vec2 p = q.front();
-        q.pop();
+        const int cell = search.pop();
+        Vec2 p{cell / cfg.cols, cell % cfg.cols};
         for (int k = 0; k < 4; ++k)
         {
             int nr = p.x + dr[k];
             int nc = p.y + dc[k];
             if (nr < 0 || nc < 0 || nr >= cfg.rows || nc >= cfg.cols)
                 continue;
-            if (visited[nr * cfg.cols + nc])
+            if (search.visited(nr * cfg.cols + nc))
                 continue;
-            if (grid[nr][nc] == '#')
+            if (map->grid[nr][nc] == '#')
                 continue;
-            visited[nr * cfg.cols + nc] = 1;
-            q.push({nr, nc});
+            search.push(nr * cfg.cols + nc, cell);
         }
     }
-    for (const auto &c : clients)
+    for (const auto &c : map->clients)
     {
-        if (!visited[c.x * cfg.cols + c.y])
+        if (!search.visited(c.x * cfg.cols + c.y))
             return false;
     }
-    for (const auto &s : stations)
+    for (const auto &s : map->stations)
     {
-        if (!visited[s.x * cfg.cols + s.y])
+        if (!search.visited(s.x * cfg.cols + s.y))
             return false;
     }
     return true;
@@ -303,30 +462,41 @@ bool Simulation::validateMap() const
 void Simulation::generateMap()
 {
     if (!mapGenerator)
-        mapGenerator = std::make_unique<ProceduralMapGenerator>();
+        mapGenerator = makeMapGenerator("PROCEDURAL");
 
-    int attempts = 0;
     const int maxAttempts = 1000;
-    bool canRegenerate = (dynamic_cast<ProceduralMapGenerator *>(mapGenerator.get()) != nullptr);
+    // generators that are valid by construction need a single pass; random
+    // ones that are not can at least be rerun with fresh randomness
+    const bool guaranteed = mapGenerator->guaranteesConnectivity();
+    const bool canRegenerate = mapGenerator->canRegenerate();
 
-    do
+    for (int attempts = 1;; ++attempts)
     {
-        mapGenerator->generate(cfg, rng, grid, basePos, clients, stations);
-        ++attempts;
-        if (!validateMap())
+        // the map ignores REPLICA: replicas race on the same streets
+        auto fresh = std::make_shared<MapData>();
+        CounterRng rng(rngSeed, RngStream::MapGeneration, 0, 0, attempts);
+        mapGenerator->generate(cfg, rng, fresh->grid, fresh->basePos, fresh->clients, fresh->stations);
+        map = std::move(fresh);
+        planners.clear();
+        routes.clear();
+        resetCooperativePlans();
+        if (guaranteed || validateMap())
         {
-            if (!canRegenerate)
-            {
-                throw MapGenerationError("Loaded map is invalid (not all clients/stations reachable from base).\n");
-                break;
-            }
-            if (attempts >= maxAttempts)
-            {
-                throw MapGenerationError(
-                    std::string("Failed to generate a valid map after ") + std::to_string(attempts) + " attempts; using last map.\n");
-            }
+            rebuildChargers();
+            rebuildGroundOracle();
+            compileRules(); // a map file sets its own size
+            return;
+        }
+        if (!canRegenerate)
+        {
+            throw MapGenerationError("Loaded map is invalid (not all clients/stations reachable from base).\n");
+        }
+        if (attempts >= maxAttempts)
+        {
+            throw MapGenerationError(
+                std::string("Failed to generate a valid map after ") + std::to_string(attempts) + " attempts; using last map.\n");
         }
-    } while (!validateMap() && canRegenerate);
+    }
 }
 
 void Simulation::loadMapFromFile(std::string mapFile)
@@ -358,7 +528,8 @@ void Simulation::loadMapFromFile(std::string mapFile)
         if (l.length() > maxlen)
             maxlen = l.length();
 
-    grid.clear();
+    auto fresh = std::make_shared<MapData>();
+    std::vector<std::string> &grid = fresh->grid;
     for (auto &l : lines)
     {
         std::string row = l;
@@ -371,8 +542,6 @@ void Simulation::loadMapFromFile(std::string mapFile)
     cfg.cols = (int)maxlen;
 
     // Discover base, clients and stations
-    clients.clear();
-    stations.clear();
     bool foundBase = false;
     for (int x = 0; x < cfg.rows; ++x)
     {
@@ -381,33 +550,40 @@ void Simulation::loadMapFromFile(std::string mapFile)
             char c = grid[x][y];
             if (c == 'B')
             {
-                basePos = {x, y};
+                fresh->basePos = {x, y};
                 foundBase = true;
             }
             else if (c == 'D')
             {
-                clients.push_back({x, y});
+                fresh->clients.push_back({x, y});
             }
             else if (c == 'S')
             {
-                stations.push_back({x, y});
+                fresh->stations.push_back({x, y});
             }
         }
     }
 
     if (!foundBase)
     {
-        basePos = {cfg.rows / 2, cfg.cols / 2};
-        grid[basePos.x][basePos.y] = 'B';
-        std::cerr << "Map has no base (B); placing base at center (" << basePos.x << "," << basePos.y << ")\n";
+        fresh->basePos = {cfg.rows / 2, cfg.cols / 2};
+        grid[fresh->basePos.x][fresh->basePos.y] = 'B';
+        std::cerr << "Map has no base (B); placing base at center (" << fresh->basePos.x << "," << fresh->basePos.y << ")\n";
     }
 
     // Keep cfg consistent with map contents (useful for debug runs)
-    cfg.clientsCount = (int)clients.size();
-    cfg.maxStations = (int)stations.size();
-
-    std::cout << "Loaded map '" << mapFile << "' (" << cfg.rows << "x" << cfg.cols << ") - clients=" << clients.size()
-              << " stations=" << stations.size() << "\n";
+    cfg.clientsCount = (int)fresh->clients.size();
+    cfg.maxStations = (int)fresh->stations.size();
+    map = std::move(fresh);
+    rebuildChargers();
+    rebuildGroundOracle();
+    compileRules(); // rules may depend on the map size
+    planners.clear();
+    routes.clear();
+    resetCooperativePlans();
+
+    std::cout << "Loaded map '" << mapFile << "' (" << cfg.rows << "x" << cfg.cols << ") - clients=" << map->clients.size()
+              << " stations=" << map->stations.size() << "\n";
     // try
     // {
 
@@ -441,8 +617,8 @@ int Simulation::computePriority(Courier *c, Package *p) const
     // 4. Operating cost for this delivery
     int opCost = eta * c->getCost();
 
-    // 5. Battery feasibility check
-    int returnDist = computeDistance(dest, basePos, c->canFly());
+    // 5. Battery feasibility check: deliver, then reach the nearest charger
+    int returnDist = chargers->distance(dest, c->canFly());
     if (returnDist < 0)
         return -1e9;
 
@@ -481,20 +657,20 @@ void Simulation::spawnCouriers()
 
     if (cfg.drones > 0)
     {
-        couriers.push_back(std::make_unique<Drone>(basePos));
+        couriers.push_back(std::make_unique<Drone>(map->basePos));
         ++activeDrones;
         std::cout << "Spawning initial Drone (1/" << cfg.drones << ")\n";
     }
     else if (cfg.robots > 0)
     {
         // If no drones configured, spawn one Robot to get the simulation started.
-        couriers.push_back(std::make_unique<Robot>(basePos));
+        couriers.push_back(std::make_unique<Robot>(map->basePos));
         ++activeRobots;
         std::cout << "Spawning initial Robot (1/" << cfg.robots << ")\n";
     }
     else if (cfg.scooters > 0)
     {
-        couriers.push_back(std::make_unique<Scooter>(basePos));
+        couriers.push_back(std::make_unique<Scooter>(map->basePos));
         ++activeScooters;
         std::cout << "Spawning initial Scooter (1/" << cfg.scooters << ")\n";
     }
@@ -506,25 +682,28 @@ void Simulation::spawnOneCourier()
     // If we can spawn more Drones, prefer them first (they were the initial courier).
     if (activeDrones < cfg.drones)
     {
-        couriers.push_back(std::make_unique<Drone>(basePos));
+        couriers.push_back(std::make_unique<Drone>(map->basePos));
         ++activeDrones;
-        std::cout << "Spawning Drone (" << activeDrones << "/" << cfg.drones << ")\n";
+        if (!quiet)
+            std::cout << "Spawning Drone (" << activeDrones << "/" << cfg.drones << ")\n";
         return;
     }
     // Then Robots
     if (activeRobots < cfg.robots)
     {
-        couriers.push_back(std::make_unique<Robot>(basePos));
+        couriers.push_back(std::make_unique<Robot>(map->basePos));
         ++activeRobots;
-        std::cout << "Spawning Robot (" << activeRobots << "/" << cfg.robots << ")\n";
+        if (!quiet)
+            std::cout << "Spawning Robot (" << activeRobots << "/" << cfg.robots << ")\n";
         return;
     }
     // Then Scooters
     if (activeScooters < cfg.scooters)
     {
-        couriers.push_back(std::make_unique<Scooter>(basePos));
+        couriers.push_back(std::make_unique<Scooter>(map->basePos));
         ++activeScooters;
-        std::cout << "Spawning Scooter (" << activeScooters << "/" << cfg.scooters << ")\n";
+        if (!quiet)
+            std::cout << "Spawning Scooter (" << activeScooters << "/" << cfg.scooters << ")\n";
         return;
     }
     // Nothing left to spawn
@@ -546,7 +725,8 @@ void Simulation::trySpawnIfNeeded()
     // Only spawn if we haven't already spawned all configured couriers
     if (activeDrones + activeRobots + activeScooters < (cfg.drones + cfg.robots + cfg.scooters))
     {
-        std::cout << "Waiting packages (" << waiting << ") reached threshold (" << waitingSpawnThreshold << ") - spawning another courier\n";
+        if (!quiet)
+            std::cout << "Waiting packages (" << waiting << ") reached threshold (" << waitingSpawnThreshold << ") - spawning another courier\n";
         spawnOneCourier();
         lastSpawnTick = currentTick;
     }
@@ -556,16 +736,49 @@ void Simulation::spawnPackage()
 {
     if (spawnedPackages >= cfg.totalPackages)
         return;
-    std::uniform_int_distribution<int> distClient(0, (int)clients.size() - 1);
+    std::uniform_int_distribution<int> distClient(0, (int)map->clients.size() - 1);
     std::uniform_int_distribution<int> reward(200, 800);
     std::uniform_int_distribution<int> deadline(10, 20);
+    if (packages.empty())
+    {
+        // the configured run never regrows these; external orders may
+        packages.reserve(cfg.totalPackages);
+        packagePool.reserve(cfg.totalPackages);
+    }
+    int id = (int)packages.size();
+    CounterRng rng(rngSeed, spawnStream, cfg.replica, currentTick, id);
     int idx = distClient(rng);
-    Vec2 d = clients[idx];
-    int id = spawnedPackages;
+    Vec2 d = map->clients[idx];
     int dl = currentTick + deadline(rng);
-    packages.push_back(std::make_unique<Package>(id, d.x, d.y, reward(rng), dl));
+    packages.push_back(std::make_unique<Package>(id, d.x, d.y, reward(rng), dl, currentTick));
     packagePool.push_back(packages.back().get());
     ++spawnedPackages;
+    ledger.onSpawn();
+}
+
+void Simulation::drainOrders()
+{
+    if (!orders)
+        return;
+    // take at most one ring's worth so steady producers cannot stall the tick
+    OrderRequest o;
+    for (size_t n = orders->capacity(); n > 0 && orders->tryPop(o); --n)
+    {
+        if (o.destX < 0 || o.destX >= cfg.rows || o.destY < 0 || o.destY >= cfg.cols ||
+            map->grid[o.destX][o.destY] == '#')
+        {
+            ++invalidOrders;
+            continue;
+        }
+        int id = (int)packages.size();
+        packages.push_back(
+            std::make_unique<Package>(id, o.destX, o.destY, o.reward, currentTick + o.deadlineTicks, currentTick));
+        packagePool.push_back(packages.back().get());
+        ++externalOrders;
+        ledger.onSpawn();
+        if (o.submittedUs > 0)
+            orderSubmittedUs[id] = o.submittedUs;
+    }
 }
 
 void Simulation::spawnPackagesIfNeeded()
@@ -578,6 +791,44 @@ void Simulation::spawnPackagesIfNeeded()
     }
 }
 
+DStarLite &Simulation::plannerFor(const Vec2 &goal) const
+{
+    int key = goal.x * cfg.cols + goal.y;
+    ++plannerClock;
+    auto it = planners.find(key);
+    if (it != planners.end())
+    {
+        it->second.lastUse = plannerClock;
+        return ownPlanner(it->second, true);
+    }
+
+    // keep the cache within PLANNER_CACHE_MB by evicting the least recently used goal
+    size_t perPlanner = (size_t)cfg.rows * cfg.cols * 2 * sizeof(int);
+    size_t budget = (size_t)std::max(1, cfg.plannerCacheMb) << 20;
+    size_t maxPlanners = std::max<size_t>(2, budget / std::max<size_t>(1, perPlanner));
+    while (planners.size() >= maxPlanners)
+    {
+        auto victim = planners.begin();
+        for (auto jt = planners.begin(); jt != planners.end(); ++jt)
+            if (jt->second.lastUse < victim->second.lastUse)
+                victim = jt;
+        planners.erase(victim);
+    }
+    auto inserted =
+        planners.emplace(key, CachedPlanner{std::make_shared<DStarLite>(cfg.rows, cfg.cols, goal), plannerClock});
+    return *inserted.first->second.planner;
+}
+
+DStarLite &Simulation::ownPlanner(CachedPlanner &entry, bool forQuery) const
+{
+    // Only holders copy the pointer, so a count of one means no fork (or
+    // parent) can see this planner. Forks run while their parent waits, and
+    // copying a planner only reads it, so concurrent rollouts may share one.
+    if (entry.planner.use_count() > 1 && !(forQuery && plannersInPlace))
+        entry.planner = std::make_shared<DStarLite>(*entry.planner);
+    return *entry.planner;
+}
+
 int Simulation::computeDistance(const Vec2 &a, const Vec2 &b, bool canFly) const
 {
     if (a.x == b.x && a.y == b.y)
@@ -586,41 +837,27 @@ int Simulation::computeDistance(const Vec2 &a, const Vec2 &b, bool canFly) const
     {
         return std::abs(a.x - b.x) + std::abs(a.y - b.y);
     }
-    // BFS on grid avoiding walls
-    std::vector<int> visited(cfg.rows * cfg.cols, 0);
-    std::queue<std::pair<Vec2, int>> q;
-    q.push({a, 0});
-    visited[a.x * cfg.cols + a.y] = 1;
-    const int dr[4] = {1, -1, 0, 0};
-    const int dc[4] = {0, 0, 1, -1};
-    while (!q.empty())
-    {
-        auto [p, d] = q.front();
-        q.pop();
-        for (int k = 0; k < 4; ++k)
-        {
-            int nr = p.x + dr[k];
-            int nc = p.y + dc[k];
-            if (nr < 0 || nc < 0 || nr >= cfg.rows || nc >= cfg.cols)
-                continue;
-            if (visited[nr * cfg.cols + nc])
-                continue;
-            if (grid[nr][nc] == '#')
-                continue;
-            if (nr == b.x && nc == b.y)
-                return d + 1;
-            visited[nr * cfg.cols + nc] = 1;
-            q.push({{nr, nc}, d + 1});
-        }
-    }
-    return -1; // unreachable
+    // ground couriers can never enter a wall, even as the destination
+    if (map->grid[b.x][b.y] == '#')
+        return -1;
+    TraceSpan span("distance");
+    if (groundOracle)
+        return groundOracle->distance(a, b);
+    return plannerFor(b).distanceFrom(map->grid, a);
 }
 
 std::vector<Vec2> Simulation::findPath(const Vec2 &a, const Vec2 &b, bool canFly) const
 {
     std::vector<Vec2> path;
+    findPath(a, b, canFly, path);
+    return path;
+}
+
+void Simulation::findPath(const Vec2 &a, const Vec2 &b, bool canFly, std::vector<Vec2> &path) const
+{
+    path.clear();
     if (a.x == b.x && a.y == b.y)
-        return path;
+        return;
     if (canFly)
     {
         // direct Manhattan moves
@@ -637,129 +874,190 @@ std::vector<Vec2> Simulation::findPath(const Vec2 &a, const Vec2 &b, bool canFly
                 --cur.y;
             path.push_back(cur);
         }
-        return path;
-    }
-    // BFS with parent pointers
-    std::vector<int> visited(cfg.rows * cfg.cols, 0);
-    std::vector<int> parent(cfg.rows * cfg.cols, -1);
-    std::queue<Vec2> q;
-    q.push(a);
-    visited[a.x * cfg.cols + a.y] = 1;
-    const int dr[4] = {1, -1, 0, 0};
-    const int dc[4] = {0, 0, 1, -1};
-    bool found = false;
-    while (!q.empty() && !found)
+        return;
+    }
+    if (map->grid[b.x][b.y] == '#')
+        return;
+    TraceSpan span("findPath");
+    if (groundOracle)
+        groundOracle->appendPath(a, b, path);
+    else
+        plannerFor(b).appendPath(map->grid, a, path);
+}
+
+static bool samePos(const Vec2 &a, const Vec2 &b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+void Simulation::moveAlongRoute(size_t courierIdx, const Vec2 &target)
+{
+    Courier &c = *couriers[courierIdx];
+    if (cfg.roadCapacity > 0 && !c.canFly())
     {
-        Vec2 p = q.front();
-        q.pop();
-        for (int k = 0; k < 4; ++k)
-        {
-            int nr = p.x + dr[k];
-            int nc = p.y + dc[k];
-            if (nr < 0 || nc < 0 || nr >= cfg.rows || nc >= cfg.cols)
-                continue;
-            if (visited[nr * cfg.cols + nc])
-                continue;
-            if (grid[nr][nc] == '#')
-                continue;
-            visited[nr * cfg.cols + nc] = 1;
-            parent[nr * cfg.cols + nc] = p.x * cfg.cols + p.y;
-            if (nr == b.x && nc == b.y)
-            {
-                found = true;
-                break;
-            }
-            q.push({nr, nc});
-        }
+        cooperativeStep(courierIdx, target);
+        return;
     }
-    if (!found)
-        return path;
-    // reconstruct
-    int idx = b.x * cfg.cols + b.y;
-    while (idx != -1 && idx != (a.x * cfg.cols + a.y))
+    CourierRoute &r = routes[courierIdx];
+    Vec2 cur = c.getPos();
+    // the cached route is still ours if it leads to the same target and we are
+    // standing where the last applied step left us
+    bool valid = samePos(r.target, target) && r.next <= r.path.size() &&
+                 (r.next == 0 ? samePos(r.start, cur) : samePos(r.path[r.next - 1], cur));
+    if (!valid)
     {
-        int row = idx / cfg.cols;
-        int col = idx % cfg.cols;
-        path.push_back({row, col});
-        idx = parent[idx];
+        r.target = target;
+        r.start = cur;
+        findPath(cur, target, c.canFly(), r.path); // reuses the route's buffer
+        r.next = 0;
+    }
+    size_t remaining = r.path.size() - r.next;
+    if (remaining > 0)
+    {
+        size_t steps = std::min(remaining, (size_t)c.getSpeed());
+        r.next += steps;
+        const int battery = c.getBattery();
+        c.applyMove(r.path[r.next - 1]);
+        ledger.onTravel(c.kind(), (int)steps, battery - c.getBattery());
     }
-    std::reverse(path.begin(), path.end());
-    return path;
 }
-// Hungarian algorithm helper for square cost matrix (minimization)
-static std::vector<int> hungarian(const std::vector<std::vector<long long>> &a)
+
+void Simulation::rebuildChargers()
 {
-    int n = (int)a.size();
-    const long long INF = (long long)4e15;
-    std::vector<long long> u(n + 1), v(n + 1);
-    std::vector<int> p(n + 1), way(n + 1);
-    for (int i = 1; i <= n; ++i)
-    {
-        p[0] = i;
-        int j0 = 0;
-        std::vector<long long> minv(n + 1, INF);
-        std::vector<char> used(n + 1, false);
-        do
+    chargers = std::make_shared<const ChargerField>(*map);
+}
+
+void Simulation::rebuildGroundOracle()
+{
+    if (!cfg.chGroundOracle)
+    {
+        groundOracle.reset();
+        return;
+    }
+    groundOracle = std::make_shared<const ContractionHierarchy>(map->grid);
+    if (!quiet)
+        std::cout << "Ground oracle: " << groundOracle->cells() << " cells, " << groundOracle->junctions()
+                  << " junctions, " << groundOracle->shortcuts() << " shortcuts, "
+                  << groundOracle->memoryBytes() / 1024 << " KiB, built in " << groundOracle->buildMillis() << " ms\n";
+}
+
+Vec2 Simulation::legTarget(const Courier &c, const Vec2 &target) const
+{
+    const bool fly = c.canFly();
+    const Vec2 pos = c.getPos();
+    const int after = chargers->distance(target, fly);
+    const int trip = computeDistance(pos, target, fly);
+    if (trip < 0 || after < 0 || c.getBattery() >= c.getMaxBattery())
+        return target; // nothing a charging stop could fix
+    auto need = [&c](int d) { return (d + c.getSpeed() - 1) / c.getSpeed() * c.getConsumption(); };
+    if (c.getBattery() >= need(trip) + need(after))
+        return target;
+    const int here = chargers->distance(pos, fly);
+    if (here < 0)
+        return target;
+    return here == 0 ? pos : chargers->nearest(pos, fly);
+}
+
+MapData &Simulation::mutableMap()
+{
+    // copy-on-write: forks may still share the current map. A sole owner may
+    // edit in place (the MapData itself was never created const).
+    if (map.use_count() > 1)
+        map = std::make_shared<MapData>(*map);
+    return const_cast<MapData &>(*map);
+}
+
+bool Simulation::setCellBlocked(const Vec2 &cell, bool blocked)
+{
+    if (!map || cell.x < 0 || cell.y < 0 || cell.x >= cfg.rows || cell.y >= cfg.cols)
+        return false;
+    // only plain road can be closed and only walls can be opened; base,
+    // clients and stations stay fixed
+    char current = map->grid[cell.x][cell.y];
+    if (blocked ? current != '.' : current != '#')
+        return false;
+
+    MapData &m = mutableMap();
+    m.grid[cell.x][cell.y] = blocked ? '#' : '.';
+    for (auto &entry : planners)
+        ownPlanner(entry.second, false).cellChanged(m.grid, cell);
+    rebuildChargers(); // O(cells); cell changes are rare next to lookups
+    rebuildGroundOracle(); // likewise a full rebuild; the hierarchy has no incremental update
+
+    // Drop only the ground routes the change touches: a closure on the rest of
+    // the route, or an opening that makes the target strictly closer.
+    for (size_t i = 0; i < routes.size() && i < couriers.size(); ++i)
+    {
+        CourierRoute &r = routes[i];
+        const Courier &c = *couriers[i];
+        if (c.canFly() || c.isDead() || r.target.x < 0)
+            continue;
+        size_t remaining = r.path.size() - std::min(r.next, r.path.size());
+        bool touched = false;
+        if (remaining == 0)
         {
-            used[j0] = true;
-            int i0 = p[j0];
-            int j1 = 0;
-            long long delta = INF;
-            for (int j = 1; j <= n; ++j)
-            {
-                if (used[j])
-                    continue;
-                long long cur = a[i0 - 1][j - 1] - u[i0] - v[j];
-                if (cur < minv[j])
-                {
-                    minv[j] = cur;
-                    way[j] = j0;
-                }
-                if (minv[j] < delta)
-                {
-                    delta = minv[j];
-                    j1 = j;
-                }
-            }
-            for (int j = 0; j <= n; ++j)
-            {
-                if (used[j])
-                {
-                    u[p[j]] += delta;
-                    v[j] -= delta;
-                }
-                else
-                {
-                    minv[j] -= delta;
-                }
-            }
-            j0 = j1;
-        } while (p[j0] != 0);
-        do
+            // an unreachable target may have become reachable
+            touched = !blocked && !samePos(c.getPos(), r.target);
+        }
+        else if (blocked)
+        {
+            for (size_t k = r.next; k < r.path.size() && !touched; ++k)
+                touched = samePos(r.path[k], cell);
+        }
+        else
         {
-            int j1 = way[j0];
-            p[j0] = p[j1];
-            j0 = j1;
-        } while (j0);
+            int d = computeDistance(c.getPos(), r.target, false);
+            touched = d >= 0 && (size_t)d < remaining;
+        }
+        if (touched)
+        {
+            r = CourierRoute{};
+            ++routeRepairs;
+        }
     }
-    std::vector<int> match(n, -1);
-    for (int j = 1; j <= n; ++j)
+    return true;
+}
+
+bool Simulation::assignToCourier(Courier &c, Package *p)
+{
+    const KpiLedger::CourierStatus before = KpiLedger::statusOf(c, map->basePos);
+    if (!c.assignPackage(p))
+        return false;
+    ledger.onAssign();
+    if (!isFork)
+        TraceRecorder::instant("assign", "package", p->getId(), "kind", (int)c.kind());
+    ledger.onCourierStatus(before, KpiLedger::statusOf(c, map->basePos));
+    poolWait.record(currentTick - p->getCreatedTick());
+    if (!orderSubmittedUs.empty())
     {
-        if (p[j] != 0)
-            match[p[j] - 1] = j - 1;
+        auto it = orderSubmittedUs.find(p->getId());
+        if (it != orderSubmittedUs.end())
+        {
+            assignLatency.record(orderClockUs() - it->second);
+            orderSubmittedUs.erase(it);
+        }
     }
-    return match;
+    return true;
 }
 
 void Simulation::hiveMindDispatch()
 {
+    // With DISPATCH_BUDGET_US the round is anytime: everything after this
+    // point watches the deadline and commits the best assignment found so far.
+    const bool budgeted = cfg.dispatchBudgetUs > 0;
+    const Deadline deadline =
+        budgeted ? std::chrono::steady_clock::now() + std::chrono::microseconds(cfg.dispatchBudgetUs) : Deadline::max();
+    bool cutShort = false;
+    TraceSpan phase("dispatch: slots");
+
     // Build list of waiting packages and available courier slots (one slot per free capacity)
-    std::vector<Package *> pkgs = packagePool; // copy pointers
+    // this round's scratch is carved from the tick arena
+    ArenaVector<Package *> pkgs(packagePool.begin(), packagePool.end(), ArenaAllocator<Package *>(arena));
     int P = (int)pkgs.size();
     if (P == 0)
         return;
 
-    std::vector<int> slotToCourier; // map column index -> courier index
+    ArenaVector<int> slotToCourier{ArenaAllocator<int>(arena)}; // map column index -> courier index
     for (size_t i = 0; i < couriers.size(); ++i)
     {
         auto &c = couriers[i];
@@ -771,49 +1069,89 @@ void Simulation::hiveMindDispatch()
     }
 
     int M = (int)slotToCourier.size();
+    lastDispatchSlots = M;
     if (M == 0)
         return; // no slots available
 
+    // at most M packages can leave the pool per round; under a budget only the
+    // oldest few per slot compete, which keeps the matrix from growing with a spike
+    if (budgeted && P > 4 * M)
+    {
+        P = 4 * M;
+        pkgs.resize(P);
+    }
+
     // size of square matrix
     int n = std::max(P, M);
-    const long long INF_COST = (long long)1e12; // large cost to forbid infeasible assignments
+    const long long INF_COST = infeasibleCost; // large cost to forbid infeasible assignments
 
     // build cost matrix: cost = -score for feasible assignments, INF_COST for infeasible
-    std::vector<std::vector<long long>> cost(n, std::vector<long long>(n, 0));
+    phase.next("dispatch: costs");
+    phase.result("size", n);
+    const CostMatrix cost{arena.allocate<long long>((size_t)n * n), n};
+
+    // per-slot terms for scoreBatch, then per row the pair inputs it scores
+    auto column = [&] { return arena.allocate<int32_t>((size_t)M); };
+    int32_t *speed = column(), *consumption = column(), *tickCost = column(), *budget = column();
+    int32_t *capacity = column(), *chargeRate = column(), *here = column(), *reach = column();
+    for (int j = 0; j < M; ++j)
+    {
+        const Courier &c = *couriers[slotToCourier[j]];
+        const int maxBattery = c.getMaxBattery();
+        capacity[j] = maxBattery - maxBattery * compiledRules[(int)c.kind()].batteryReservePct / 100;
+        budget[j] = c.getBattery() - (maxBattery - capacity[j]);
+        speed[j] = c.getSpeed();
+        consumption[j] = c.getConsumption();
+        tickCost[j] = c.getCost();
+        chargeRate[j] = std::max(1, maxBattery / 4); // per tick on a charger
+        here[j] = chargers->distance(c.getPos(), c.canFly());
+        // ceil(a/s) + ceil(b/s) >= ceil((a+b)/s), so a trip past this many
+        // cells cannot fit a full battery
+        reach[j] = consumption[j] > 0 ? capacity[j] / consumption[j] * speed[j] : INT_MAX;
+    }
+    int32_t *dist = column(), *outBound = column(), *after = column();
+    ScoreBatch batch;
+    batch.count = M;
+    batch.speed = speed;
+    batch.consumption = consumption;
+    batch.cost = tickCost;
+    batch.budget = budget;
+    batch.capacity = capacity;
+    batch.chargeRate = chargeRate;
+    batch.here = here;
+    batch.dist = dist;
+    batch.outBound = outBound;
+    batch.after = after;
 
     for (int i = 0; i < P; ++i)
     {
         Package *pkg = pkgs[i];
+        // out of time: the remaining (newest) packages wait for the next round
+        if (budgeted && !cutShort && std::chrono::steady_clock::now() >= deadline)
+            cutShort = true;
+        if (cutShort)
+        {
+            std::fill(cost[i], cost[i] + M, INF_COST);
+            continue;
+        }
         for (int j = 0; j < M; ++j)
         {
             int courierIdx = slotToCourier[j];
-            auto &c = couriers[courierIdx];
-            if (c->isDead())
+            PairInputs in;
+            if (j > 0 && slotToCourier[j - 1] == courierIdx)
+                in = {dist[j - 1], outBound[j - 1], after[j - 1]}; // slots of one courier score alike
+            else if (!couriers[courierIdx]->isDead())
             {
-                cost[i][j] = INF_COST;
-                continue;
+                // feasibility rules and distances, specialised per courier type
+                const Courier &c = *couriers[courierIdx];
+                const CompiledRule &rule = compiledRules[(int)c.kind()];
+                in = rule.inputs(*this, c, *pkg, rule, reach[j]);
             }
-            // quick feasibility checks mirroring previous heuristic
-            Vec2 courierPos = c->getPos();
-            int dist = computeDistance(courierPos, {pkg->getDestX(), pkg->getDestY()}, c->canFly());
-            if (dist < 0) { cost[i][j] = INF_COST; continue; }
-            if (c->typeName() == "Drone" && pkg->getReward() < 300) { cost[i][j] = INF_COST; continue; }
-            if (c->typeName() == "Robot" && dist > cfg.rows / 3) { cost[i][j] = INF_COST; continue; }
-
-            int ticksNeeded = (dist + c->getSpeed() - 1) / c->getSpeed();
-            int batteryNeeded = ticksNeeded * c->getConsumption();
-            int minReturnDist = computeDistance({pkg->getDestX(), pkg->getDestY()}, basePos, c->canFly());
-            if (minReturnDist < 0) { cost[i][j] = INF_COST; continue; }
-            int returnTicks = (minReturnDist + c->getSpeed() - 1) / c->getSpeed();
-            int batteryReturn = returnTicks * c->getConsumption();
-            if (c->getBattery() < (batteryNeeded + batteryReturn)) { cost[i][j] = INF_COST; continue; }
-
-            int score = computePriority(c.get(), pkg);
-            if (score <= -1000000)
-                cost[i][j] = INF_COST; // infeasible
-            else
-                cost[i][j] = - (long long)score; // minimize -score == maximize score
+            dist[j] = in.dist;
+            outBound[j] = in.outBound;
+            after[j] = in.after;
         }
+        scoreBatch(batch, pkg->getReward(), pkg->getDeadline(), currentTick, INF_COST, cost[i]);
         for (int j = M; j < n; ++j)
         {
             // dummy columns: represent leaving the package unassigned (0 cost)
@@ -827,11 +1165,34 @@ void Simulation::hiveMindDispatch()
             cost[i][j] = 0;
     }
 
-    // Solve assignment via Hungarian
-    std::vector<int> match = hungarian(cost); // size n, match[row] = col
+    // Solve the assignment: exactly, or within the budget as greedy first,
+    // then local search, then the exact solver if there is still time
+    phase.next("dispatch: solve");
+    std::vector<int> &match = dispatchMatch; // size n, match[row] = col
+    if (!budgeted)
+        hungarianAssign(cost, match);
+    else
+    {
+        if (!greedyAssign(cost, match, deadline) || !improveAssignment(cost, match, deadline))
+            cutShort = true;
+        else
+        {
+            std::vector<int> &exact = dispatchExact;
+            if (hungarianAssign(cost, exact, deadline))
+            {
+                if (assignmentCost(cost, exact) <= assignmentCost(cost, match))
+                    match.swap(exact);
+            }
+            else
+                cutShort = true;
+        }
+        if (cutShort)
+            ++dispatchBudgetHits;
+    }
 
     // Apply assignments: if row < P and matched col < M and cost not INF_COST, assign
-    std::vector<char> assigned(P, false);
+    phase.next("dispatch: apply");
+    ArenaVector<char> assigned(P, false, ArenaAllocator<char>(arena));
     for (int i = 0; i < P; ++i)
     {
         int j = match[i];
@@ -843,7 +1204,7 @@ void Simulation::hiveMindDispatch()
         auto &c = couriers[courierIdx];
         if (c->isDead() || !c->hasFreeCapacity())
             continue; // safety check
-        bool ok = c->assignPackage(pkgs[i]);
+        bool ok = assignToCourier(*c, pkgs[i]);
         if (ok)
             assigned[i] = true;
     }
@@ -858,7 +1219,7 @@ void Simulation::hiveMindDispatch()
     {
         const long long FALLBACK_THRESHOLD = -1000; // allow small losses to keep system busy
         struct Cand { long long profit; int pi; int col; };
-        std::vector<Cand> cands;
+        ArenaVector<Cand> cands{ArenaAllocator<Cand>(arena)};
         cands.reserve(P * M);
         for (int i = 0; i < P; ++i)
         {
@@ -871,8 +1232,8 @@ void Simulation::hiveMindDispatch()
         }
         std::sort(cands.begin(), cands.end(), [](const Cand &a, const Cand &b){ return a.profit > b.profit; });
 
-        std::vector<char> courierUsed(M, false);
-        std::vector<char> pkgUsed(P, false);
+        ArenaVector<char> courierUsed(M, false, ArenaAllocator<char>(arena));
+        ArenaVector<char> pkgUsed(P, false, ArenaAllocator<char>(arena));
         int toTake = std::min(P, M);
         for (const auto &cand : cands)
         {
@@ -883,7 +1244,7 @@ void Simulation::hiveMindDispatch()
             int courierIdx = slotToCourier[cand.col];
             auto &c = couriers[courierIdx];
             if (c->isDead() || !c->hasFreeCapacity()) continue;
-            bool ok = c->assignPackage(pkgs[cand.pi]);
+            bool ok = assignToCourier(*c, pkgs[cand.pi]);
             if (ok)
             {
                 assigned[cand.pi] = true;
@@ -894,42 +1255,16 @@ void Simulation::hiveMindDispatch()
         }
     }
 
-    // remove assigned packages from packagePool
-    std::vector<Package *> newPool;
-    newPool.reserve(packagePool.size());
-    for (auto p : packagePool)
-    {
-        bool wasAssigned = false;
-        for (int i = 0; i < P; ++i)
-        {
-            if (assigned[i] && pkgs[i] == p)
-            {
-                wasAssigned = true;
-                break;
-            }
-        }
-        if (!wasAssigned)
-            newPool.push_back(p);
-    }
-    packagePool.swap(newPool);
     // If we assigned nothing, all packages have been spawned, and there are
     // still waiting packages but no active couriers able to take them,
     // try a last-resort forced assignment before ending the simulation
     // (this relaxes heuristic constraints so packages are attempted one way or another).
     if (assignedCount == 0 && P > 0 && spawnedPackages >= cfg.totalPackages)
     {
-        int activeAgents = 0;
-        for (const auto &c : couriers)
-        {
-            if (c->isDead())
-                continue;
-            bool isActive = !c->getPackages().empty() || (c->getPos().x != basePos.x || c->getPos().y != basePos.y);
-            if (isActive)
-                ++activeAgents;
-        }
-        if (activeAgents == 0)
+        if (ledger.activeCouriers == 0)
         {
-            std::cout << "No active couriers and no feasible assignments detected; attempting forced assignments\n";
+            if (!quiet)
+                std::cout << "No active couriers and no feasible assignments detected; attempting forced assignments\n";
 
             int forcedAssigned = 0;
             // Greedily assign each waiting package to the nearest courier that can reach it (ignoring battery/heuristics)
@@ -955,7 +1290,7 @@ void Simulation::hiveMindDispatch()
                 if (bestCourier != -1)
                 {
                     auto &c = couriers[bestCourier];
-                    bool ok = c->assignPackage(pkg);
+                    bool ok = assignToCourier(*c, pkg);
                     if (ok)
                     {
                         assigned[i] = true;
@@ -966,96 +1301,212 @@ void Simulation::hiveMindDispatch()
 
             if (forcedAssigned > 0)
             {
-                std::cout << "Forced assignment succeeded: " << forcedAssigned << " packages assigned\n";
+                if (!quiet)
+                    std::cout << "Forced assignment succeeded: " << forcedAssigned << " packages assigned\n";
                 assignedCount += forcedAssigned;
             }
             else
             {
-                std::cout << "No available couriers could reach remaining packages; ending simulation early\n";
+                if (!quiet)
+                    std::cout << "No available couriers could reach remaining packages; ending simulation early\n";
                 setAllDelivered();
             }
         }
     }
+
+    // remove assigned packages (including forced ones) from packagePool;
+    // pkgs is the head of the pool, so assigned[] is indexed like the pool
+    size_t kept = 0;
+    for (size_t i = 0; i < packagePool.size(); ++i)
+        if (i >= (size_t)P || !assigned[i])
+            packagePool[kept++] = packagePool[i];
+    packagePool.resize(kept);
+}
+
+static long long microsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 void Simulation::step()
 {
-    // spawn packages
+    arena.reset();
+    TraceSpan tick("tick", "tick", currentTick);
+    TraceSpan phase("spawn");
+    auto phaseStart = std::chrono::steady_clock::now();
+    AllocCounts allocMark = AllocTracker::thisThread();
+    // spawn packages, external orders first
+    drainOrders();
     spawnPackagesIfNeeded();
 
     // maybe spawn additional couriers if backlog grows
     trySpawnIfNeeded();
+    phaseTimes.spawn += microsSince(phaseStart);
+    phaseAllocs.spawn += AllocTracker::lap(allocMark);
 
     // dispatch
-    hiveMindDispatch();
+    phase.next("dispatch");
+    phaseStart = std::chrono::steady_clock::now();
+    lastDispatchPackages = (int)packagePool.size();
+    lastDispatchSlots = 0;
+    if (cfg.lookaheadHorizon > 0)
+        lookaheadDispatch();
+    else
+        hiveMindDispatch();
+    lastDispatchMicros = (int)microsSince(phaseStart);
+    phaseTimes.dispatch += lastDispatchMicros;
+    phaseAllocs.dispatch += AllocTracker::lap(allocMark);
+
+    phase.next("movement");
+    phaseStart = std::chrono::steady_clock::now();
+    advanceCouriers();
+    phaseTimes.movement += microsSince(phaseStart);
+    phaseAllocs.movement += AllocTracker::lap(allocMark);
+
+    if (telemetry && currentTick % std::max(1, cfg.telemetryInterval) == 0)
+    {
+        phase.next("telemetry");
+        phaseStart = std::chrono::steady_clock::now();
+        recordTelemetry();
+        phaseTimes.telemetry += microsSince(phaseStart);
+        phaseAllocs.telemetry += AllocTracker::lap(allocMark);
+    }
+}
 
+void Simulation::openTelemetry()
+{
+    if (cfg.telemetryFile.empty())
+        return;
+    auto format = cfg.telemetryFormat == "BINARY" ? TelemetryWriter::Format::BINARY : TelemetryWriter::Format::CSV;
+    telemetry = std::make_unique<TelemetryWriter>(cfg.telemetryFile, format);
+}
+
+void Simulation::recordTelemetry()
+{
+    TelemetrySample s;
+    s.tick = currentTick;
+    s.waiting = (int)packagePool.size();
+    s.delivered = ledger.delivered;
+    s.deliveredLate = ledger.deliveredLate;
+    s.latenessTicks = (int32_t)ledger.latenessTicks;
+    s.profit = (int32_t)ledger.provisionalProfit();
+    s.deadAgents = ledger.deadAgents;
+    s.active = ledger.activeCouriers;
+    s.carrying = ledger.carryingCouriers;
+    for (const auto &c : couriers)
+    {
+        if (c->isDead())
+            continue;
+        int quarter = std::min(3, 4 * c->getBattery() / std::max(1, c->getMaxBattery()));
+        ++s.battery[(int)c->kind()][quarter];
+    }
+    s.dispatchPackages = lastDispatchPackages;
+    s.dispatchSlots = lastDispatchSlots;
+    s.dispatchMicros = lastDispatchMicros;
+    try
+    {
+        telemetry->write(s);
+    }
+    catch (const TelemetryError &ex)
+    {
+        // the run itself is fine; carry on without the stream
+        std::cerr << "Telemetry disabled: " << ex.what();
+        telemetry.reset();
+    }
+}
+
+void Simulation::closeTelemetry()
+{
+    if (!telemetry)
+        return;
+    try
+    {
+        telemetry->close();
+    }
+    catch (const TelemetryError &ex)
+    {
+        std::cerr << "Telemetry incomplete: " << ex.what();
+        telemetry.reset();
+    }
+}
+
+void Simulation::advanceCouriers()
+{
     // move couriers and accumulate operating cost per tick
-    for (auto &c : couriers)
-    {   
-        if (c->isDead()) continue;       // don't run movement logic for dead couriers
-        operatingCostTotal += c->getCost();
-        if (!c->getPackages().empty())
+    routes.resize(couriers.size());
+    if (cfg.roadCapacity > 0 && currentTick % std::max(1, cfg.whcaWindow) == 0)
+        reservations.expireBefore(currentTick);
+    for (size_t ci = 0; ci < couriers.size(); ++ci)
+        advanceCourier(ci);
+
+    ++currentTick;
+}
+
+void Simulation::advanceCourier(size_t ci)
+{
+    auto &c = couriers[ci];
+    if (c->isDead())
+        return; // don't run movement logic for dead couriers
+    const KpiLedger::CourierStatus before = KpiLedger::statusOf(*c, map->basePos);
+    ledger.onOperatingCost(c->getCost());
+    if (!c->getPackages().empty())
+    {
+        Package *p = c->getPackages().front();
+        Vec2 target{p->getDestX(), p->getDestY()};
+        moveAlongRoute(ci, legTarget(*c, target));
+        // check arrival
+        if (c->getPos().x == target.x && c->getPos().y == target.y)
         {
-            Package *p = c->getPackages().front();
-            Vec2 target{p->getDestX(), p->getDestY()};
-            Vec2 cur = c->getPos();
-            auto path = findPath(cur, target, c->canFly());
-            if (!path.empty())
-            {
-                int steps = std::min((int)path.size(), c->getSpeed());
-                Vec2 next = path[steps - 1];
-                c->applyMove(next);
-            }
-            // check arrival
-            if (c->getPos().x == target.x && c->getPos().y == target.y)
-            {
-                p->markDelivered(currentTick);
-                c->removePackage(p);
-            }
+            p->markDelivered(currentTick);
+            if (!isFork)
+                TraceRecorder::instant("deliver", "package", p->getId(), "courier", (int)ci);
+            ledger.onDeliver(p->getReward(), currentTick, p->getDeadline());
+            deliveryLatency.record(currentTick - p->getCreatedTick());
+            if (currentTick > p->getDeadline())
+                deliveryLateness.record(currentTick - p->getDeadline());
+            if (spawnedPackages >= cfg.totalPackages && ledger.delivered == ledger.spawned)
+                setAllDelivered();
+            c->removePackage(p);
         }
-        else
+    }
+    else
+    {
+        // idle at base: if not at base, move back
+        if (c->getPos().x != map->basePos.x || c->getPos().y != map->basePos.y)
         {
-            // idle at base: if not at base, move back
-            if (c->getPos().x != basePos.x || c->getPos().y != basePos.y)
-            {
-                Vec2 cur = c->getPos();
-                auto path = findPath(cur, basePos, c->canFly());
-                if (!path.empty())
-                {
-                    int steps = std::min((int)path.size(), c->getSpeed());
-                    Vec2 next = path[steps - 1];
-                    c->applyMove(next);
-                }
-            }
-            else
-            {
-                // recharge at base
-                int add = c->getMaxBattery() / 4;
-                c->recharge(add);
-            }
+            moveAlongRoute(ci, legTarget(*c, map->basePos));
         }
-
-        // after movement, check if courier is on S or B to recharge a bit
-        char cell = grid[c->getPos().x][c->getPos().y];
-        if (cell == 'S' || cell == 'B')
+        else
         {
+            // recharge at base
             int add = c->getMaxBattery() / 4;
             c->recharge(add);
         }
+    }
 
-        // check dead state
-        if (c->getBattery() == 0)
+    // after movement, check if courier is on S or B to recharge a bit
+    char cell = map->grid[c->getPos().x][c->getPos().y];
+    if (cell == 'S' || cell == 'B')
+    {
+        int add = c->getMaxBattery() / 4;
+        c->recharge(add);
+    }
+
+    // check dead state
+    if (c->getBattery() == 0)
+    {
+        char cellHere = map->grid[c->getPos().x][c->getPos().y];
+        if (cellHere != 'S' && cellHere != 'B')
         {
-            char cellHere = grid[c->getPos().x][c->getPos().y];
-            if (cellHere != 'S' && cellHere != 'B')
-            {
-                c->kill();
-                ++deadAgents;
-            }
+            c->kill();
+            if (!isFork)
+                TraceRecorder::instant("death", "courier", (int)ci);
+            ledger.onCourierDeath(c->kind());
         }
     }
-
-    ++currentTick;
+    const KpiLedger::CourierStatus after = KpiLedger::statusOf(*c, map->basePos);
+    ledger.onCourierStatus(before, after);
+    ledger.onCourierTicks(c->kind(), 1, after.active);
 }
 
 void Simulation::run()
@@ -1063,23 +1514,72 @@ void Simulation::run()
     try
     {
         loadConfig();
-        generateMap();
-        // loadMapFromFile("map.txt");
-        spawnCouriers();
+        auto setupStart = std::chrono::steady_clock::now();
+        AllocCounts allocMark = AllocTracker::thisThread();
+        if (!cfg.resumeSnapshot.empty())
+        {
+            loadSnapshot(cfg.resumeSnapshot);
+            std::cout << "Resumed from snapshot '" << cfg.resumeSnapshot << "' at tick " << currentTick << "\n";
+        }
+        else
+        {
+            generateMap();
+            // loadMapFromFile("map.txt");
+            spawnCouriers();
+        }
+        phaseTimes.setup += microsSince(setupStart);
+        phaseAllocs.setup += AllocTracker::lap(allocMark);
+
+        openTelemetry();
+        openFrameExport();
+        openTrace();
+        openSharedState();
+        publishState();
+
+        if (!cfg.serviceSocket.empty())
+        {
+            DispatchService(*this, cfg.serviceSocket, cfg.serviceTickMs).run();
+            closeTelemetry();
+            if (tracer)
+                exportTrace();
+            writeReport();
+            return;
+        }
 
         // initial render
-        render();
+        if (!cfg.headless)
+            render();
+        if (frames)
+            captureFrame();
 
         while (currentTick < cfg.maxTicks)
         {
-            step();
-            render();
+            advance();
+            publishState();
+            if (!cfg.headless)
+            {
+                auto renderStart = std::chrono::steady_clock::now();
+                allocMark = AllocTracker::thisThread();
+                render();
+                phaseTimes.render += microsSince(renderStart);
+                phaseAllocs.render += AllocTracker::lap(allocMark);
+            }
+            // the event engine may jump past a multiple of the interval
+            if (frames && currentTick - lastFrameTick >= std::max(1, cfg.frameInterval))
+                captureFrame();
+            if (!cfg.snapshotFile.empty() && cfg.snapshotInterval > 0 && currentTick % cfg.snapshotInterval == 0)
+                saveSnapshot(cfg.snapshotFile);
             if (Simulation::isAllDelivered())
             {
                 break;
             }
         }
 
+        closeTelemetry();
+        if (frames)
+            frames->close();
+        if (tracer)
+            exportTrace();
         writeReport();
     }
     catch (const FileOpenError &ex)
@@ -1093,44 +1593,124 @@ void Simulation::run()
         std::terminate();
         // ^^^^ could also be `std::exit(EXIT_FAILURE);`
     }
+    catch (const SnapshotError &ex)
+    {
+        std::cerr << "Fatal snapshot error: " << ex.what() << std::endl;
+        std::terminate();
+    }
+    catch (const ServiceError &ex)
+    {
+        std::cerr << "Fatal service error: " << ex.what() << std::endl;
+        std::terminate();
+    }
 }
 
 void Simulation::writeReport() const
 {
+    if (!cfg.reportJson.empty())
+        writeJsonReport(cfg.reportJson);
     std::ofstream out("simulation.txt");
     if (!out)
         return;
-    int delivered = 0;
-    int delayed = 0;
-    int lost = 0;
-    int profit = 0;
-    for (const auto &p : packages)
+    out << "Delivered: " << ledger.delivered << "\n";
+    out << "Delayed: " << ledger.deliveredLate << "\n";
+    out << "Lost: " << ledger.lost() << "\n";
+    out << "Operating cost: " << ledger.operatingCost << "\n";
+    out << "Dead agents: " << ledger.deadAgents << "\n";
+    out << "Profit: " << ledger.finalProfit() << "\n";
+    if (cfg.lookaheadHorizon > 0)
     {
-        if (p->isDelivered())
-        {
-            ++delivered;
-            profit += p->getReward();
-            if (p->deliveredAt() > p->getDeadline())
-            {
-                ++delayed;
-                profit -= 50; // penalty
-            }
-        }
-        else
-        {
-            ++lost;
-            profit -= 200; // undelivered penalty
-        }
+        out << "Lookahead overrides: " << lookaheadOverrides << "\n";
+        out << "Lookahead budget hits: " << lookaheadBudgetHits << "\n";
+    }
+    if (cfg.eventEngine)
+        out << "Ticks skipped by the event engine: " << skippedTicks << "\n";
+    if (cfg.roadCapacity > 0)
+        out << "Road reservation conflicts: " << reservationConflicts << "\n";
+    if (cfg.dispatchBudgetUs > 0)
+        out << "Dispatch budget hits: " << dispatchBudgetHits << "\n";
+    if (AllocTracker::compiledIn)
+    {
+        out << "Allocations per tick: p50 " << tickAllocations.percentile(0.5) << ", p99 "
+            << tickAllocations.percentile(0.99) << ", max " << tickAllocations.max() << " (bytes p50 "
+            << tickAllocBytes.percentile(0.5) << ", p99 " << tickAllocBytes.percentile(0.99) << ", max "
+            << tickAllocBytes.max() << ")\n";
+        out << "Allocations by phase: setup " << phaseAllocs.setup.allocations << ", spawn "
+            << phaseAllocs.spawn.allocations << ", dispatch " << phaseAllocs.dispatch.allocations << ", movement "
+            << phaseAllocs.movement.allocations << ", telemetry " << phaseAllocs.telemetry.allocations
+            << ", render " << phaseAllocs.render.allocations << "\n";
+        out << "Peak RSS: " << AllocTracker::peakRssKb() << " KB\n";
     }
-    // subtract operating cost
-    profit -= operatingCostTotal;
-    // dead agent penalty
-    profit -= deadAgents * 500;
-
-    out << "Delivered: " << delivered << "\n";
-    out << "Delayed: " << delayed << "\n";
-    out << "Lost: " << lost << "\n";
-    out << "Operating cost: " << operatingCostTotal << "\n";
-    out << "Dead agents: " << deadAgents << "\n";
-    out << "Profit: " << profit << "\n";
+    if (frames)
+        out << "Frames exported: " << frames->written() << " (dropped " << frames->dropped() << ")\n";
+    if (groundOracle)
+        out << "Ground oracle: " << groundOracle->junctions() << " junctions / " << groundOracle->cells()
+            << " cells, " << groundOracle->shortcuts() << " shortcuts, " << groundOracle->memoryBytes()
+            << " bytes, built in " << groundOracle->buildMillis() << " ms\n";
+    if (orders && orders->accepted() + orders->rejected() > 0)
+    {
+        out << "External orders: " << externalOrders << " (invalid " << invalidOrders << ", rejected "
+            << orders->rejected() << ")\n";
+        out << "Order queue high-water: " << orders->highWater() << " / " << orders->capacity() << "\n";
+    }
+}
+
+static void writeDistribution(std::ostream &out, const char *name, const LatencyHistogram &h, bool last = false)
+{
+    out << "  \"" << name << "\": {\"count\": " << h.count() << ", \"p50\": " << h.percentile(0.50)
+        << ", \"p90\": " << h.percentile(0.90) << ", \"p99\": " << h.percentile(0.99) << ", \"max\": " << h.max()
+        << "}" << (last ? "\n" : ",\n");
+}
+
+void Simulation::writeJsonReport(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "Could not write JSON report: " << path << "\n";
+        return;
+    }
+    out << "{\n";
+    out << "  \"ticks\": " << currentTick << ",\n";
+    out << "  \"packages\": {\"spawned\": " << ledger.spawned << ", \"delivered\": " << ledger.delivered
+        << ", \"late\": " << ledger.deliveredLate << ", \"lost\": " << ledger.lost() << "},\n";
+    out << "  \"operating_cost\": " << ledger.operatingCost << ",\n";
+    out << "  \"dead_agents\": " << ledger.deadAgents << ",\n";
+    out << "  \"profit\": " << ledger.finalProfit() << ",\n";
+
+    int spawned[3] = {};
+    for (const auto &c : couriers)
+        ++spawned[(int)c->kind()];
+    static const char *const kindNames[3] = {"drone", "robot", "scooter"};
+    out << "  \"couriers\": {\n";
+    for (int k = 0; k < 3; ++k)
+    {
+        const KpiLedger::FleetKpis &f = ledger.fleet[k];
+        const double utilization = f.aliveTicks ? (double)f.busyTicks / f.aliveTicks : 0.0;
+        out << "    \"" << kindNames[k] << "\": {\"count\": " << spawned[k] << ", \"utilization\": " << std::fixed
+            << std::setprecision(4) << utilization << std::defaultfloat << ", \"energy_used\": " << f.energyUsed
+            << ", \"distance\": " << f.distance << ", \"deaths\": " << f.deaths << "}" << (k < 2 ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    out << "  \"peak_rss_kb\": " << AllocTracker::peakRssKb() << ",\n";
+    if (AllocTracker::compiledIn)
+    {
+        const std::pair<const char *, const AllocCounts *> phases[] = {
+            {"setup", &phaseAllocs.setup},       {"spawn", &phaseAllocs.spawn},
+            {"dispatch", &phaseAllocs.dispatch}, {"movement", &phaseAllocs.movement},
+            {"telemetry", &phaseAllocs.telemetry}, {"render", &phaseAllocs.render}};
+        out << "  \"allocations_by_phase\": {\n";
+        for (size_t k = 0; k < std::size(phases); ++k)
+            out << "    \"" << phases[k].first << "\": {\"count\": " << phases[k].second->allocations
+                << ", \"bytes\": " << phases[k].second->bytes << "}" << (k + 1 < std::size(phases) ? ",\n" : "\n");
+        out << "  },\n";
+        writeDistribution(out, "allocations_per_tick", tickAllocations);
+        writeDistribution(out, "alloc_bytes_per_tick", tickAllocBytes);
+    }
+
+    writeDistribution(out, "delivery_latency_ticks", deliveryLatency);
+    writeDistribution(out, "lateness_ticks", deliveryLateness);
+    writeDistribution(out, "pool_wait_ticks", poolWait);
+    writeDistribution(out, "assign_latency_us", assignLatency, true);
+    out << "}\n";
 }
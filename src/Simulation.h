@@ -6,6 +6,26 @@
 #include <random>
 #include "Courier.h"
 #include "Package.h"
+#include "MapData.h"
+#include "DStarLite.h"
+#include "ChargerField.h"
+#include "ContractionHierarchy.h"
+#include "TelemetryWriter.h"
+#include "FrameExporter.h"
+#include "TraceRecorder.h"
+#include "SharedState.h"
+#include "AllocTracker.h"
+#include "TickArena.h"
+#include "SearchWorkspace.h"
+#include "KpiLedger.h"
+#include "DispatchRules.h"
+#include "OrderQueue.h"
+#include "LatencyHistogram.h"
+#include "ReservationTable.h"
+#include "CounterRng.h"
+#include <climits>
+#include <map>
+#include <unordered_map>
 
 struct Config {
     int rows = 20;
@@ -19,6 +39,53 @@ struct Config {
     int totalPackages = 50;
     int spawnFrequency = 10;
     int displayDelayMs = 100; // milliseconds between ticks when rendering
+    int lookaheadHorizon = 0;     // ticks simulated forward per candidate plan (0 = myopic dispatch)
+    int lookaheadCandidates = 4;  // candidate first-step plans evaluated per tick
+    int lookaheadBudgetUs = 2000; // hard wall-clock budget for the lookahead per tick
+    int lookaheadThreads = 0;     // worker threads for rollouts (0 = hardware concurrency)
+    int plannerCacheMb = 256;     // memory for cached per-goal ground planners
+    std::string telemetryFile;    // per-tick telemetry stream ("" = disabled)
+    std::string telemetryFormat = "CSV"; // CSV or BINARY (columnar)
+    int telemetryInterval = 1;    // ticks between telemetry samples
+    std::string snapshotFile;     // periodic binary snapshot target ("" = disabled)
+    int snapshotInterval = 0;     // ticks between snapshots (0 = disabled)
+    std::string resumeSnapshot;   // restore this snapshot instead of generating a new run
+    RuleTable rules;              // per-courier-type dispatch feasibility (RULE: lines)
+    long long seed = -1;          // fixed RNG seed for reproducible runs (-1 = random)
+    int replica = 0;              // REPLICA: demand stream under the same seed and map
+    bool headless = false;        // skip terminal rendering (benchmarks, batch runs)
+    bool eventEngine = false;     // ENGINE: EVENT jumps over idle ticks (see EventEngine.cpp)
+    int orderQueueCapacity = 1024; // external order ring size (rounded up to a power of two)
+    std::string serviceSocket;    // Unix socket path: run as a dispatch service ("" = batch run)
+    int serviceTickMs = 100;      // wall-clock tick period in service mode
+    int roadCapacity = 0;         // ground couriers per road cell and tick (0 = unlimited, 1 = cooperative paths)
+    int whcaWindow = 8;           // cooperative planning window in ticks
+    int dispatchBudgetUs = 0;     // wall-clock budget per dispatch round (0 = always solve exactly)
+    bool chGroundOracle = false;  // GROUND_ORACLE: CH answers ground queries from a contraction hierarchy
+    std::string frameDir;         // image sequence target directory ("" = no frame export)
+    int frameInterval = 1;        // ticks between exported frames
+    int frameScale = 4;           // pixels per cell side
+    int frameBuffer = 64;         // frames queued for the writer thread before drops
+    std::string traceFile;        // Chrome trace JSON target ("" = no tracing)
+    int traceBuffer = 65536;      // trace events kept per thread
+    std::string reportJson;       // structured end-of-run report ("" = text report only)
+    std::string sharedState;      // POSIX shared-memory name for live state, e.g. /hive ("" = not published)
+};
+
+// Wall time spent in each phase of a run, in microseconds.
+struct PhaseTimes {
+    long long setup = 0;     // map generation / snapshot restore and initial couriers
+    long long spawn = 0;     // package and courier spawning
+    long long dispatch = 0;
+    long long movement = 0;  // advanceCouriers
+    long long telemetry = 0;
+    long long render = 0;
+};
+
+// Heap allocations made in each phase (ALLOC_TRACKING=1 builds); lookahead
+// workers' allocations count towards dispatch.
+struct PhaseAllocs {
+    AllocCounts setup, spawn, dispatch, movement, telemetry, render;
 };
 
 #include "IMapGenerator.h"
@@ -57,6 +124,33 @@ public:
     void setAllDelivered();
     void loadMapFromFile(std::string mapFile);
 
+    // Binary snapshot of the full run state (config, map, couriers, packages,
+    // pool, counters and RNG). loadSnapshot restores it in a single pass.
+    void saveSnapshot(const std::string& path) const;
+    void loadSnapshot(const std::string& path);
+    // In-process copy for what-if branches: shares the immutable map and copies
+    // only mutable state. The fork is not registered as the singleton.
+    std::unique_ptr<Simulation> fork() const;
+
+    // Dynamic obstacles: close a road cell ('.' -> '#') or reopen a wall
+    // ('#' -> '.') mid-run. Cached distances are repaired incrementally and only
+    // routes that pass the cell (or get shorter) are replanned. Returns false if
+    // the cell is out of range or not of the expected kind.
+    bool setCellBlocked(const Vec2& cell, bool blocked);
+
+    // External orders: producer threads push into this queue and step()
+    // drains it at the start of the next tick. Obtain it after loadConfig,
+    // which may resize it; pending orders are not part of snapshots.
+    OrderQueue& orderQueue() { return *orders; }
+    // submission-to-assignment latency of orders that carried a timestamp
+    const LatencyHistogram& getAssignLatency() const { return assignLatency; }
+
+    // read-only run statistics, e.g. for benchmarks
+    int getCurrentTick() const { return currentTick; }
+    const KpiLedger& getLedger() const { return ledger; }
+    const PhaseTimes& getPhaseTimes() const { return phaseTimes; }
+    const PhaseAllocs& getPhaseAllocs() const { return phaseAllocs; }
+
 #ifdef UNIT_TEST
     // Test-only helpers (exposed only when compiled with -DUNIT_TEST)
 public:
@@ -72,8 +166,43 @@ public:
     std::vector<Vec2> callFindPathForTest(const Vec2 &a, const Vec2 &b, bool canFly) const { return findPath(a,b,canFly); }
 
     // test-only helpers
-    int getDeadAgentsForTest() const { return deadAgents; }
+    int getDeadAgentsForTest() const { return ledger.deadAgents; }
+    int getLookaheadBudgetHitsForTest() const { return lookaheadBudgetHits; }
+    int getRouteRepairsForTest() const { return routeRepairs; }
+    bool plannerSharedForTest(const Vec2& goal) const
+    {
+        auto it = planners.find(goal.x * cfg.cols + goal.y);
+        return it != planners.end() && it->second.planner.use_count() > 1;
+    }
+    int callComputeDistanceForTest(const Vec2 &a, const Vec2 &b, bool canFly) const { return computeDistance(a,b,canFly); }
+    Config& getConfigForTest() { return cfg; }
+    void callCompileRulesForTest() { compileRules(); }
+    void callOpenTelemetryForTest() { openTelemetry(); }
+    void closeTelemetryForTest() { closeTelemetry(); }
+    bool hasTelemetryForTest() const { return telemetry != nullptr; }
+    const MapData& getMapForTest() const { return *map; }
+    const ChargerField& getChargersForTest() const { return *chargers; }
     void callStepForTest() { step(); }
+    void callAdvanceForTest() { advance(); }
+    int getSkippedTicksForTest() const { return skippedTicks; }
+    int getReservationConflictsForTest() const { return reservationConflicts; }
+    // the cell courier ci's cooperative plan holds at `tick`, and the cell it passes on the way in
+    bool cooperativePlanAtForTest(size_t ci, int tick, Vec2& cell, Vec2& via) const
+    {
+        if (ci >= stPlans.size() || tick < stPlans[ci].start || tick - stPlans[ci].start >= (int)stPlans[ci].cells.size())
+            return false;
+        cell = stPlans[ci].cells[tick - stPlans[ci].start];
+        via = stPlans[ci].via[tick - stPlans[ci].start];
+        return true;
+    }
+    int getDispatchBudgetHitsForTest() const { return dispatchBudgetHits; }
+    const ContractionHierarchy* getGroundOracleForTest() const { return groundOracle.get(); }
+    FrameExporter* openFrameExportForTest() { openFrameExport(); return frames.get(); }
+    void captureFrameForTest() { captureFrame(); }
+    TraceRecorder* openTraceForTest() { openTrace(); return tracer.get(); }
+    void writeJsonReportForTest(const std::string& path) const { writeJsonReport(path); }
+    StatePublisher* openSharedStateForTest() { openSharedState(); return sharedState.get(); }
+    void publishStateForTest() { publishState(); }
 private:
 #endif
 
@@ -81,10 +210,45 @@ private:
     Config cfg;
     std::string configPath;
 
-    std::vector<std::string> grid; // rows strings of length cols
-    Vec2 basePos;
-    std::vector<Vec2> clients;
-    std::vector<Vec2> stations;
+    std::shared_ptr<const MapData> map; // shared between forks, copy-on-write (see mutableMap)
+    MapData& mutableMap();
+
+    // nearest-charger field of the current map, shared with forks like the map
+    std::shared_ptr<const ChargerField> chargers;
+    void rebuildChargers();
+    // ground distance oracle under GROUND_ORACLE: CH (null otherwise), shared
+    // with forks; rebuilt from scratch whenever the map changes
+    std::shared_ptr<const ContractionHierarchy> groundOracle;
+    void rebuildGroundOracle();
+    // where a courier bound for `target` should head now: the target itself,
+    // or the nearest charger when the battery cannot cover the trip plus
+    // reaching a charger afterwards (its own position while recharging)
+    Vec2 legTarget(const Courier& c, const Vec2& target) const;
+
+    // per-courier cached route, indexed like `couriers`
+    struct CourierRoute {
+        Vec2 target{-1, -1};
+        Vec2 start{-1, -1};
+        std::vector<Vec2> path; // cells after start, ending at target
+        size_t next = 0;        // path[next - 1] is where the courier should be now
+    };
+    std::vector<CourierRoute> routes;
+    void moveAlongRoute(size_t courierIdx, const Vec2& target);
+
+    // cooperative ground movement under ROAD_CAPACITY: 1 (windowed
+    // hierarchical cooperative A*, see CooperativePaths.cpp)
+    struct SpaceTimePlan {
+        Vec2 target{-1, -1};
+        int start = 0;           // tick of cells[0]
+        std::vector<Vec2> cells; // cells[k] = position at tick start + k
+        std::vector<Vec2> via;   // cell passed on the way into cells[k] ({-1, -1} = none)
+    };
+    std::vector<SpaceTimePlan> stPlans; // indexed like `couriers`
+    ReservationTable reservations;      // (cell, tick) -> courier index
+    int reservationConflicts = 0;       // forced moves into a cell held by another courier
+    void cooperativeStep(size_t courierIdx, const Vec2& target);
+    void planCooperative(size_t courierIdx, const Vec2& target);
+    void resetCooperativePlans();
 
     std::vector<std::unique_ptr<Courier>> couriers;
     std::vector<std::unique_ptr<Package>> packages; // all packages (spawned)
@@ -93,8 +257,35 @@ private:
     int currentTick = 0;
     int spawnedPackages = 0;
 
-    int operatingCostTotal = 0;
-    int deadAgents = 0;
+    KpiLedger ledger;
+    void rebuildLedger(); // recount from packages/couriers after a snapshot restore
+    // assigns through the courier and records the assignment and any status change
+    bool assignToCourier(Courier& c, Package* p);
+
+    PhaseTimes phaseTimes;
+    PhaseAllocs phaseAllocs;
+    LatencyHistogram tickAllocations, tickAllocBytes; // per advance(), not copied into forks
+
+    // size and wall time of the most recent dispatch round (for telemetry)
+    int lastDispatchPackages = 0;
+    int lastDispatchSlots = 0;
+    int lastDispatchMicros = 0;
+
+    std::unique_ptr<TelemetryWriter> telemetry; // never shared with forks
+    void openTelemetry(); // per cfg.telemetryFile / telemetryFormat
+    void recordTelemetry();
+    void closeTelemetry(); // flushes; a write failure only disables telemetry
+
+    std::unique_ptr<FrameExporter> frames; // never shared with forks
+    int lastFrameTick = -1;
+    void openFrameExport(); // per cfg.frameDir
+    void captureFrame();    // current state, coloured like render()
+    std::unique_ptr<TraceRecorder> tracer; // never shared with forks
+    void openTrace();   // per cfg.traceFile; SIGUSR1 asks for an export
+    void exportTrace(); // to cfg.traceFile
+    std::unique_ptr<StatePublisher> sharedState; // never shared with forks
+    void openSharedState(); // per cfg.sharedState
+    void publishState();    // this tick's frame, if open
 
     // active counts of spawned couriers by type (do NOT exceed cfg.* values)
     int activeDrones = 0;
@@ -109,27 +300,114 @@ private:
     // tick when we last performed an automatic spawn due to backlog (initialized far in the past)
     int lastSpawnTick = -1000000;
 
-    std::mt19937 rng;
+    // every draw comes from a CounterRng stream keyed off this (SEED:, or random)
+    uint64_t rngSeed = 0;
+    RngStream spawnStream = RngStream::PackageSpawn; // lookahead forks imagine their own demand
 
     // map generation strategy
     std::unique_ptr<IMapGenerator> mapGenerator;
     bool validateMap() const;
+    mutable SearchWorkspace search; // validateMap's BFS
 
     bool allDelivered = false;
     void spawnPackage();
     void spawnPackagesIfNeeded();
 
+    std::unique_ptr<OrderQueue> orders; // null on forks
+    int externalOrders = 0;             // drained into packages
+    int invalidOrders = 0;              // drained but dropped (off-map or wall destination)
+    void drainOrders();
+    std::unordered_map<int, long long> orderSubmittedUs; // package id -> submission time, until assigned
+    LatencyHistogram assignLatency;
+    // per-package distributions in ticks, streamed so no per-package records are kept
+    LatencyHistogram deliveryLatency;  // spawn to delivery
+    LatencyHistogram deliveryLateness; // past the deadline, late deliveries only
+    LatencyHistogram poolWait;         // spawn to assignment
+
+    friend class DispatchService; // drives ticks and reads state in service mode
+
     // Singleton support
     static Simulation* singletonInstance;
 
+    // fork() support: copies mutable state without touching the singleton
+    struct ForkTag {};
+    Simulation(const Simulation& parent, ForkTag);
+
     // lazy spawning helpers
     void spawnOneCourier();
     void trySpawnIfNeeded();
 
+    // goal-rooted incremental planners shared by computeDistance and findPath,
+    // evicted least-recently-used beyond cfg.plannerCacheMb. Forks share them
+    // copy-on-write: queries update a planner, so whoever holds a shared one
+    // copies it first (ownPlanner), and a fork pays only for goals it queries.
+    struct CachedPlanner {
+        std::shared_ptr<DStarLite> planner;
+        unsigned long long lastUse;
+    };
+    mutable std::map<int, CachedPlanner> planners;
+    mutable unsigned long long plannerClock = 0;
+    DStarLite& plannerFor(const Vec2& goal) const;
+    // `forQuery`: queries on an unchanged map only advance the search, so a
+    // fork running on its parent's thread (plannersInPlace) may share them
+    DStarLite& ownPlanner(CachedPlanner& entry, bool forQuery) const;
+    bool plannersInPlace = false;
+    int routeRepairs = 0; // routes dropped because a cell change touched them
+
     int computeDistance(const Vec2& a, const Vec2& b, bool canFly) const;
     std::vector<Vec2> findPath(const Vec2& a, const Vec2& b, bool canFly) const;
+    void findPath(const Vec2& a, const Vec2& b, bool canFly, std::vector<Vec2>& out) const; // reuses out
     void hiveMindDispatch();
+    // Per-tick scratch (dispatch matrix and lists, cooperative search nodes),
+    // reset at the start of every tick; never shared with forks.
+    TickArena arena;
+    std::vector<int> dispatchMatch, dispatchExact; // solver output, kept for its capacity
+    int dispatchBudgetHits = 0; // rounds that committed a non-exact assignment under DISPATCH_BUDGET_US
+
+    // cfg.rules compiled into one pair-input function per courier type (see
+    // DispatchRules.cpp); recompiled whenever the config or rows change. The
+    // inputs feed scoreBatch (PairScoring.h), which turns them into costs.
+    static constexpr long long infeasibleCost = (long long)1e12;
+    struct PairInputs {
+        int32_t dist = -1; // courier -> destination, -1 when a rule or the map rules the pair out
+        int32_t outBound = 0;
+        int32_t after = 0; // destination -> its nearest charger
+    };
+    struct CompiledRule;
+    // `reach`: cells a full (reserve-adjusted) battery can cover at most
+    using PairInputsFn = PairInputs (*)(const Simulation&, const Courier&, const Package&, const CompiledRule&,
+                                        int reach);
+    struct CompiledRule {
+        PairInputsFn inputs = nullptr;
+        int minReward = -1;
+        int maxDistance = -1;
+        int batteryReservePct = 0;
+    };
+    CompiledRule compiledRules[3]; // indexed by CourierKind
+    void compileRules();
+    template <CourierKind K, bool MinReward, bool MaxDistance>
+    static PairInputs pairInputs(const Simulation& sim, const Courier& c, const Package& p, const CompiledRule& rule,
+                                 int reach);
+
+    // rolling-horizon dispatch: scores candidate first steps by rolling forks
+    // forward cfg.lookaheadHorizon ticks (see LookaheadDispatch.cpp)
+    void lookaheadDispatch();
+    int lookaheadOverrides = 0;  // ticks where lookahead picked a plan other than the myopic one
+    int lookaheadBudgetHits = 0; // ticks where the rollouts were cut short by the budget
+    bool quiet = false;          // suppress progress messages (set on rollout forks)
+    bool isFork = false;         // a hypothetical copy: its events stay out of the trace
 
     void step();
+    void advanceCouriers(); // movement, charging and death checks; ends the tick
+    void advanceCourier(size_t courierIdx); // one courier's share of advanceCouriers
+
+    // discrete-event engine: advance() steps one tick, or with cfg.eventEngine
+    // jumps over the ticks until the next event (at most maxTicks) when
+    // nothing can happen; returns the ticks covered
+    int advance(int maxTicks = INT_MAX);
+    int idleTicksAvailable() const; // 0 if the next tick must be stepped
+    void fastForward(int ticks);
+    int skippedTicks = 0;           // ticks covered by fastForward instead of step
     void writeReport() const;
+    void writeJsonReport(const std::string& path) const; // per cfg.reportJson
 };
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include "Simulation.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include "BinaryIO.h"
+#include "Errors.h"
+
+// Snapshot layout (host byte order):
+//   magic "HIVESNAP", u32 version
+//   config ints, map (grid rows, base, clients, stations)
+//   counters, RNG seed (u64) and replica (i32)
+//   packages (id, dest, reward, deadline, delivered tick or -1, created tick)
+//   packagePool as package ids
+//   couriers (type tag, pos, speed, battery, dead flag, carried package ids)
+static const char snapshotMagic[8] = {'H', 'I', 'V', 'E', 'S', 'N', 'A', 'P'};
+static const uint32_t snapshotVersion = 3; // 1 lacked package creation ticks, 2 stored an mt19937
+
+static char courierTag(const Courier &c)
+{
+    return c.typeName()[0]; // 'D'rone, 'R'obot, 'S'cooter
+}
+
+static std::unique_ptr<Courier> makeCourier(char tag, Vec2 pos)
+{
+    switch (tag)
+    {
+    case 'D':
+        return std::make_unique<Drone>(pos);
+    case 'R':
+        return std::make_unique<Robot>(pos);
+    case 'S':
+        return std::make_unique<Scooter>(pos);
+    default:
+        throw SnapshotError(std::string("Unknown courier type in snapshot: ") + tag + "\n");
+    }
+}
+
+Simulation::Simulation(const Simulation &parent, ForkTag)
+    : cfg(parent.cfg),
+      configPath(parent.configPath),
+      map(parent.map),
+      chargers(parent.chargers),
+      groundOracle(parent.groundOracle),
+      routes(parent.routes),
+      stPlans(parent.stPlans),
+      reservations(parent.reservations),
+      reservationConflicts(parent.reservationConflicts),
+      currentTick(parent.currentTick),
+      spawnedPackages(parent.spawnedPackages),
+      ledger(parent.ledger),
+      activeDrones(parent.activeDrones),
+      activeRobots(parent.activeRobots),
+      activeScooters(parent.activeScooters),
+      lastSpawnTick(parent.lastSpawnTick),
+      rngSeed(parent.rngSeed),
+      spawnStream(parent.spawnStream),
+      mapGenerator(nullptr),
+      allDelivered(parent.allDelivered),
+      planners(parent.planners),
+      plannerClock(parent.plannerClock),
+      routeRepairs(parent.routeRepairs),
+      lookaheadOverrides(parent.lookaheadOverrides),
+      lookaheadBudgetHits(parent.lookaheadBudgetHits),
+      quiet(parent.quiet),
+      isFork(true)
+{
+    compileRules();
+
+    // Package ids are their index in `packages`, which lets us re-point the
+    // pool and courier loads at the copies.
+    packages.reserve(parent.packages.size());
+    for (const auto &p : parent.packages)
+        packages.push_back(std::make_unique<Package>(*p));
+
+    packagePool.reserve(parent.packagePool.size());
+    for (Package *p : parent.packagePool)
+        packagePool.push_back(packages[p->getId()].get());
+
+    couriers.reserve(parent.couriers.size());
+    std::vector<Package *> load;
+    for (const auto &c : parent.couriers)
+    {
+        auto copy = c->clone();
+        load.clear();
+        for (Package *p : c->getPackages())
+            load.push_back(packages[p->getId()].get());
+        copy->rebindPackages(load);
+        couriers.push_back(std::move(copy));
+    }
+}
+
+std::unique_ptr<Simulation> Simulation::fork() const
+{
+    return std::unique_ptr<Simulation>(new Simulation(*this, ForkTag{}));
+}
+
+void Simulation::saveSnapshot(const std::string &path) const
+{
+    if (!map)
+        throw SnapshotError("Cannot snapshot a simulation without a map\n");
+
+    // Write to a temporary file and rename so a crash mid-write never leaves
+    // a half-written snapshot in place of the previous good one.
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw FileOpenError("Could not open snapshot file: " + tmpPath + "\n");
+        BinaryWriter w(out);
+
+        out.write(snapshotMagic, sizeof(snapshotMagic));
+        w.pod(snapshotVersion);
+
+        const int32_t cfgInts[] = {cfg.rows, cfg.cols, cfg.maxTicks, cfg.maxStations, cfg.clientsCount,
+                                   cfg.drones, cfg.robots, cfg.scooters, cfg.totalPackages, cfg.spawnFrequency};
+        for (int32_t v : cfgInts)
+            w.pod(v);
+
+        w.pod<uint32_t>((uint32_t)map->grid.size());
+        for (const auto &row : map->grid)
+            w.str(row);
+        w.pod(map->basePos);
+        w.podVector(map->clients);
+        w.podVector(map->stations);
+
+        const int32_t counters[] = {currentTick, spawnedPackages, ledger.operatingCost, ledger.deadAgents,
+                                    activeDrones, activeRobots, activeScooters, lastSpawnTick,
+                                    allDelivered ? 1 : 0};
+        for (int32_t v : counters)
+            w.pod(v);
+
+        w.pod<uint64_t>(rngSeed);
+        w.pod<int32_t>(cfg.replica);
+
+        w.pod<uint32_t>((uint32_t)packages.size());
+        for (const auto &p : packages)
+        {
+            const int32_t rec[] = {p->getId(), p->getDestX(), p->getDestY(), p->getReward(), p->getDeadline(),
+                                   p->isDelivered() ? p->deliveredAt() : -1, p->getCreatedTick()};
+            for (int32_t v : rec)
+                w.pod(v);
+        }
+
+        w.pod<uint32_t>((uint32_t)packagePool.size());
+        for (Package *p : packagePool)
+            w.pod<int32_t>(p->getId());
+
+        w.pod<uint32_t>((uint32_t)couriers.size());
+        for (const auto &c : couriers)
+        {
+            w.pod(courierTag(*c));
+            w.pod(c->getPos());
+            w.pod<int32_t>(c->getSpeed());
+            w.pod<int32_t>(c->getBattery());
+            w.pod<uint8_t>(c->isDead() ? 1 : 0);
+            w.pod<uint32_t>((uint32_t)c->getPackages().size());
+            for (Package *p : c->getPackages())
+                w.pod<int32_t>(p->getId());
+        }
+
+        if (!out)
+            throw SnapshotError("Failed while writing snapshot: " + tmpPath + "\n");
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        throw SnapshotError("Could not move snapshot into place: " + path + "\n");
+}
+
+void Simulation::loadSnapshot(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw FileOpenError("Could not open snapshot file: " + path + "\n");
+    BinaryReader r(in);
+
+    char magic[sizeof(snapshotMagic)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, snapshotMagic, sizeof(magic)) != 0)
+        throw SnapshotError("Not a HiveMind snapshot: " + path + "\n");
+    const uint32_t version = r.pod<uint32_t>();
+    if (version < 1 || version > snapshotVersion)
+        throw SnapshotError("Unsupported snapshot version: " + path + "\n");
+
+    // Only the run-defining part of the config is restored; display and
+    // snapshot options keep their current values.
+    int *cfgInts[] = {&cfg.rows, &cfg.cols, &cfg.maxTicks, &cfg.maxStations, &cfg.clientsCount,
+                      &cfg.drones, &cfg.robots, &cfg.scooters, &cfg.totalPackages, &cfg.spawnFrequency};
+    for (int *v : cfgInts)
+        *v = r.pod<int32_t>();
+
+    auto fresh = std::make_shared<MapData>();
+    uint32_t rows = r.pod<uint32_t>();
+    fresh->grid.reserve(rows);
+    for (uint32_t i = 0; i < rows; ++i)
+        fresh->grid.push_back(r.str());
+    fresh->basePos = r.pod<Vec2>();
+    fresh->clients = r.podVector<Vec2>();
+    fresh->stations = r.podVector<Vec2>();
+    if ((int)fresh->grid.size() != cfg.rows)
+        throw SnapshotError("Snapshot map does not match its config: " + path + "\n");
+    map = std::move(fresh);
+    rebuildChargers();
+    rebuildGroundOracle();
+    planners.clear();
+    routes.clear(); // derived data: rebuilt from the restored positions
+    resetCooperativePlans();
+
+    int allDeliveredFlag = 0;
+    int *counters[] = {&currentTick, &spawnedPackages, &ledger.operatingCost, &ledger.deadAgents,
+                       &activeDrones, &activeRobots, &activeScooters, &lastSpawnTick,
+                       &allDeliveredFlag};
+    for (int *v : counters)
+        *v = r.pod<int32_t>();
+    allDelivered = allDeliveredFlag != 0;
+
+    if (version >= 3)
+    {
+        rngSeed = r.pod<uint64_t>();
+        cfg.replica = r.pod<int32_t>();
+    }
+    else
+    {
+        // an mt19937 state: the counter-based streams cannot continue it,
+        // so the resumed run keeps the configured seed
+        r.str();
+    }
+
+    uint32_t packageCount = r.pod<uint32_t>();
+    packages.clear();
+    packages.reserve(packageCount);
+    for (uint32_t i = 0; i < packageCount; ++i)
+    {
+        int32_t rec[7] = {};
+        for (int k = 0; k < (version >= 2 ? 7 : 6); ++k)
+            rec[k] = r.pod<int32_t>();
+        if (rec[0] != (int32_t)i)
+            throw SnapshotError("Snapshot package ids are out of order: " + path + "\n");
+        packages.push_back(std::make_unique<Package>(rec[0], rec[1], rec[2], rec[3], rec[4], rec[6]));
+        if (rec[5] >= 0)
+            packages.back()->markDelivered(rec[5]);
+    }
+
+    auto packageById = [&](int32_t id) -> Package * {
+        if (id < 0 || id >= (int32_t)packages.size())
+            throw SnapshotError("Snapshot references unknown package " + std::to_string(id) + "\n");
+        return packages[id].get();
+    };
+
+    uint32_t poolSize = r.pod<uint32_t>();
+    packagePool.clear();
+    packagePool.reserve(poolSize);
+    for (uint32_t i = 0; i < poolSize; ++i)
+        packagePool.push_back(packageById(r.pod<int32_t>()));
+
+    uint32_t courierCount = r.pod<uint32_t>();
+    couriers.clear();
+    couriers.reserve(courierCount);
+    std::vector<Package *> load;
+    for (uint32_t i = 0; i < courierCount; ++i)
+    {
+        char tag = r.pod<char>();
+        Vec2 pos = r.pod<Vec2>();
+        int speed = r.pod<int32_t>();
+        int battery = r.pod<int32_t>();
+        bool dead = r.pod<uint8_t>() != 0;
+        auto c = makeCourier(tag, pos);
+        c->restoreState(pos, speed, battery, dead);
+        uint32_t carried = r.pod<uint32_t>();
+        load.clear();
+        for (uint32_t k = 0; k < carried; ++k)
+            load.push_back(packageById(r.pod<int32_t>()));
+        c->rebindPackages(load);
+        couriers.push_back(std::move(c));
+    }
+    compileRules(); // rules may depend on the restored map size
+    // the rest of the ledger is derived from the restored packages and couriers
+    rebuildLedger();
+}
+
+void Simulation::rebuildLedger()
+{
+    KpiLedger fresh;
+    fresh.operatingCost = ledger.operatingCost;
+    fresh.deadAgents = ledger.deadAgents;
+    fresh.spawned = (int)packages.size();
+    fresh.assigned = fresh.spawned - (int)packagePool.size();
+    deliveryLatency = LatencyHistogram();
+    deliveryLateness = LatencyHistogram();
+    for (const auto &p : packages)
+    {
+        if (!p->isDelivered())
+            continue;
+        fresh.onDeliver(p->getReward(), p->deliveredAt(), p->getDeadline());
+        deliveryLatency.record(p->deliveredAt() - p->getCreatedTick());
+        if (p->deliveredAt() > p->getDeadline())
+            deliveryLateness.record(p->deliveredAt() - p->getDeadline());
+    }
+    for (const auto &c : couriers)
+    {
+        fresh.onCourierStatus({}, KpiLedger::statusOf(*c, map->basePos));
+        fresh.fleet[(int)c->kind()].deaths += c->isDead();
+    }
+    // ticks, distance and energy are not in the snapshot and restart at zero
+    ledger = fresh;
+}
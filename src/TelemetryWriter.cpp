@@ -0,0 +1,169 @@
+#include "TelemetryWriter.h"
+#include "Errors.h"
+
+#include <charconv>
+#include <cstring>
+
+static void flatten(const TelemetrySample &s, int32_t *v)
+{
+    int k = 0;
+    v[k++] = s.tick;
+    v[k++] = s.waiting;
+    v[k++] = s.active;
+    v[k++] = s.carrying;
+    v[k++] = s.delivered;
+    v[k++] = s.deliveredLate;
+    v[k++] = s.latenessTicks;
+    v[k++] = s.profit;
+    v[k++] = s.deadAgents;
+    for (int t = 0; t < 3; ++t)
+        for (int q = 0; q < 4; ++q)
+            v[k++] = s.battery[t][q];
+    v[k++] = s.dispatchPackages;
+    v[k++] = s.dispatchSlots;
+    v[k++] = s.dispatchMicros;
+}
+
+const std::vector<std::string> &TelemetryWriter::columnNames()
+{
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> n = {"tick", "waiting", "active", "carrying", "delivered",
+                                      "delivered_late", "lateness_ticks", "profit", "dead_agents"};
+        for (const char *type : {"drone", "robot", "scooter"})
+            for (const char *q : {"q0", "q1", "q2", "q3"})
+                n.push_back(std::string(type) + "_battery_" + q);
+        n.push_back("dispatch_packages");
+        n.push_back("dispatch_slots");
+        n.push_back("dispatch_us");
+        return n;
+    }();
+    return names;
+}
+
+TelemetryWriter::TelemetryWriter(const std::string &path, Format format)
+    : out(path, std::ios::binary | std::ios::trunc), format(format)
+{
+    if (!out)
+        throw FileOpenError("Could not open telemetry file: " + path + "\n");
+    buffer.reserve(bufferBytes);
+    const auto &names = columnNames();
+    if (format == Format::CSV)
+    {
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (i)
+                buffer.push_back(',');
+            buffer.insert(buffer.end(), names[i].begin(), names[i].end());
+        }
+        buffer.push_back('\n');
+    }
+    else
+    {
+        columns.assign(names.size() * blockRows, 0);
+        auto putU32 = [&](uint32_t v) {
+            const char *p = reinterpret_cast<const char *>(&v);
+            buffer.insert(buffer.end(), p, p + sizeof(v));
+        };
+        const char magic[8] = {'H', 'I', 'V', 'E', 'T', 'L', 'M', '1'};
+        buffer.insert(buffer.end(), magic, magic + sizeof(magic));
+        putU32((uint32_t)names.size());
+        for (const auto &n : names)
+        {
+            putU32((uint32_t)n.size());
+            buffer.insert(buffer.end(), n.begin(), n.end());
+        }
+    }
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // never throw from a destructor; a failed final flush loses the tail only
+    }
+}
+
+void TelemetryWriter::write(const TelemetrySample &s)
+{
+    if (closed)
+        return;
+    if (format == Format::CSV)
+    {
+        appendCsv(s);
+        if (buffer.size() > bufferBytes - 1024)
+            flushBuffer();
+        return;
+    }
+    int32_t row[64];
+    flatten(s, row);
+    const size_t ncols = columnNames().size();
+    for (size_t c = 0; c < ncols; ++c)
+        columns[c * blockRows + rowsInBlock] = row[c];
+    if (++rowsInBlock == blockRows)
+        appendBlock();
+}
+
+void TelemetryWriter::appendCsv(const TelemetrySample &s)
+{
+    int32_t row[64];
+    flatten(s, row);
+    const size_t ncols = columnNames().size();
+    char line[64 * 12 + 1]; // up to 11 chars per int32 plus separator
+    char *const end = line + sizeof(line) - 1;
+    char *p = line;
+    for (size_t c = 0; c < ncols && p < end; ++c)
+    {
+        if (c)
+            *p++ = ',';
+        p = std::to_chars(p, end, row[c]).ptr;
+    }
+    *p++ = '\n';
+    buffer.insert(buffer.end(), line, p);
+}
+
+void TelemetryWriter::appendBlock()
+{
+    if (rowsInBlock == 0)
+        return;
+    const size_t ncols = columnNames().size();
+    uint32_t n = (uint32_t)rowsInBlock;
+    const char *np = reinterpret_cast<const char *>(&n);
+    buffer.insert(buffer.end(), np, np + sizeof(n));
+    for (size_t c = 0; c < ncols; ++c)
+    {
+        const char *col = reinterpret_cast<const char *>(&columns[c * blockRows]);
+        buffer.insert(buffer.end(), col, col + rowsInBlock * sizeof(int32_t));
+    }
+    rowsInBlock = 0;
+    if (buffer.size() > bufferBytes / 2)
+        flushBuffer();
+}
+
+void TelemetryWriter::flushBuffer()
+{
+    if (buffer.empty())
+        return;
+    out.write(buffer.data(), (std::streamsize)buffer.size());
+    buffer.clear();
+    if (!out)
+        throw TelemetryError("Failed while writing telemetry\n");
+}
+
+void TelemetryWriter::close()
+{
+    if (closed)
+        return;
+    closed = true;
+    if (format == Format::BINARY)
+        appendBlock();
+    flushBuffer();
+    out.flush();
+    const bool ok = (bool)out;
+    out.close();
+    if (!ok)
+        throw TelemetryError("Failed while writing telemetry\n");
+}
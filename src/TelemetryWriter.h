@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One telemetry row, sampled every cfg.telemetryInterval ticks.
+struct TelemetrySample {
+    int32_t tick = 0;
+    int32_t waiting = 0;         // packages in packagePool
+    int32_t active = 0;          // alive couriers carrying or away from base
+    int32_t carrying = 0;        // alive couriers with at least one package
+    int32_t delivered = 0;       // cumulative
+    int32_t deliveredLate = 0;   // cumulative
+    int32_t latenessTicks = 0;   // cumulative ticks past deadline
+    int32_t profit = 0;          // cumulative provisional profit
+    int32_t deadAgents = 0;
+    int32_t battery[3][4] = {};  // [drone, robot, scooter][quarter of max battery]
+    int32_t dispatchPackages = 0;
+    int32_t dispatchSlots = 0;
+    int32_t dispatchMicros = 0;
+};
+
+// Buffered writer for the telemetry stream. Rows are formatted into a large
+// in-memory buffer and only hit the file in big chunks.
+//
+//   CSV:    header line, then one line per sample.
+//   BINARY: "HIVETLM1", u32 column count, column names (u32 length + bytes),
+//           then blocks of up to blockRows rows: u32 row count followed by
+//           each column's int32 values stored contiguously.
+class TelemetryWriter {
+public:
+    enum class Format { CSV, BINARY };
+
+    TelemetryWriter(const std::string& path, Format format);
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    void write(const TelemetrySample& s);
+    void close(); // flushes everything; safe to call twice
+
+    static const std::vector<std::string>& columnNames();
+
+private:
+    static constexpr size_t bufferBytes = 1 << 20;
+    static constexpr size_t blockRows = 4096;
+
+    void appendCsv(const TelemetrySample& s);
+    void appendBlock();
+    void flushBuffer();
+
+    std::ofstream out;
+    Format format;
+    std::vector<char> buffer;
+    std::vector<int32_t> columns; // BINARY: column-major staging for one block
+    size_t rowsInBlock = 0;
+    bool closed = false;
+};
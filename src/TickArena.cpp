@@ -0,0 +1,45 @@
+#include "TickArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+static size_t alignUp(uintptr_t p, size_t align)
+{
+    return (size_t)((align - p % align) % align);
+}
+
+void *TickArena::allocate(size_t bytes, size_t align)
+{
+    if (block)
+    {
+        const uintptr_t base = (uintptr_t)block.get();
+        const size_t pad = alignUp(base + used, align);
+        if (used + pad + bytes <= blockSize)
+        {
+            void *p = block.get() + used + pad;
+            used += pad + bytes;
+            return p;
+        }
+    }
+    // spill: a chunk of its own, folded into the block on the next reset()
+    const size_t chunk = std::max<size_t>(bytes + align, 4096);
+    overflow.push_back(std::make_unique<std::byte[]>(chunk));
+    overflowBytes += chunk;
+    std::byte *raw = overflow.back().get();
+    return raw + alignUp((uintptr_t)raw, align);
+}
+
+void TickArena::reset()
+{
+    const size_t tick = used + overflowBytes;
+    peak = std::max(peak, tick);
+    if (!overflow.empty())
+    {
+        // room for the busiest tick so far plus headroom
+        blockSize = std::max(blockSize, peak + peak / 2);
+        block = std::make_unique<std::byte[]>(blockSize);
+        overflow.clear();
+        overflowBytes = 0;
+    }
+    used = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Monotonic scratch memory for one tick. allocate() bumps a pointer and
+// reset() drops everything at once; nothing is freed in between. A tick that
+// outgrows the block spills into overflow chunks, and the next reset()
+// replaces them with a single block big enough for that tick, so once the
+// largest tick has been seen the arena stops allocating.
+class TickArena {
+public:
+    void* allocate(size_t bytes, size_t align);
+    template <class T>
+    T* allocate(size_t n)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+    void reset();
+
+    size_t capacity() const { return blockSize; }
+    size_t highWater() const { return peak; } // bytes in the busiest tick so far
+
+private:
+    std::unique_ptr<std::byte[]> block;
+    size_t blockSize = 0;
+    size_t used = 0;
+    std::vector<std::unique_ptr<std::byte[]>> overflow;
+    size_t overflowBytes = 0;
+    size_t peak = 0;
+};
+
+// Lets standard containers live in a TickArena; deallocation is a no-op, so
+// such a container must not outlive the arena's next reset().
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    TickArena* arena;
+
+    explicit ArenaAllocator(TickArena& a) : arena(&a) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& o) : arena(o.arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.arena; }
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
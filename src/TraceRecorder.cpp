@@ -0,0 +1,169 @@
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+struct TraceRecorder::Ring {
+    std::vector<Event> events;
+    std::atomic<uint64_t> head{0}; // events ever written; only the owning thread stores
+    int lane;                      // Chrome trace "tid"
+    const char *name = "worker";
+    Ring(size_t capacity, int lane) : events(capacity), lane(lane) {}
+};
+
+std::atomic<TraceRecorder *> TraceRecorder::current{nullptr};
+
+namespace {
+
+std::mutex registryMutex;
+uint64_t nextGeneration = 1; // registry mutex
+
+int64_t steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+// The calling thread's ring, handed back to the recorder's free list when the
+// thread exits (if that recorder still exists).
+struct ThreadRing {
+    TraceRecorder *owner = nullptr;
+    uint64_t generation = 0;
+    TraceRecorder::Ring *ring = nullptr;
+
+    ~ThreadRing()
+    {
+        if (!ring)
+            return;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        TraceRecorder *rec = TraceRecorder::current.load();
+        if (rec == owner && rec->generation == generation)
+            rec->freeRings.push_back(ring);
+    }
+};
+
+static thread_local ThreadRing threadRing;
+
+TraceRecorder::TraceRecorder(size_t eventsPerThread)
+    : capacity(std::max<size_t>(16, eventsPerThread)), originNs(steadyNs())
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (current.load())
+        throw std::runtime_error("A trace recorder is already active");
+    generation = nextGeneration++;
+    current.store(this, std::memory_order_release);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (current.load() == this)
+        current.store(nullptr, std::memory_order_release);
+}
+
+int64_t TraceRecorder::now() const
+{
+    return steadyNs() - originNs;
+}
+
+TraceRecorder::Ring *TraceRecorder::ringForThisThread()
+{
+    ThreadRing &t = threadRing;
+    if (t.owner == this && t.generation == generation)
+        return t.ring;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Ring *ring;
+    if (!freeRings.empty())
+    {
+        ring = freeRings.back();
+        freeRings.pop_back();
+    }
+    else
+    {
+        rings.push_back(std::make_unique<Ring>(capacity, (int)rings.size()));
+        ring = rings.back().get();
+    }
+    t.owner = this;
+    t.generation = generation;
+    t.ring = ring;
+    return ring;
+}
+
+void TraceRecorder::record(const Event &e)
+{
+    Ring *ring = ringForThisThread();
+    const uint64_t h = ring->head.load(std::memory_order_relaxed);
+    ring->events[h % capacity] = e;
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+void TraceRecorder::instant(const char *name, const char *arg0, int32_t v0, const char *arg1, int32_t v1)
+{
+    if (TraceRecorder *rec = active())
+        rec->record({name, {arg0, arg1}, {v0, v1}, rec->now(), -1});
+}
+
+void TraceRecorder::nameThisThread(const char *name)
+{
+    ringForThisThread()->name = name;
+}
+
+long long TraceRecorder::recorded() const
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    long long n = 0;
+    for (const auto &ring : rings)
+        n += (long long)ring->head.load(std::memory_order_acquire);
+    return n;
+}
+
+long long TraceRecorder::retained() const
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    long long n = 0;
+    for (const auto &ring : rings)
+        n += (long long)std::min<uint64_t>(ring->head.load(std::memory_order_acquire), capacity);
+    return n;
+}
+
+bool TraceRecorder::exportJson(const std::string &path) const
+{
+    std::FILE *f = std::fopen(path.c_str(), "w");
+    if (!f)
+        return false;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", f);
+    bool first = true;
+    auto separator = [&]() {
+        std::fputs(first ? "" : ",\n", f);
+        first = false;
+    };
+    for (const auto &ring : rings)
+    {
+        separator();
+        std::fprintf(f, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                     ring->lane, ring->name);
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = head - std::min<uint64_t>(head, capacity); i < head; ++i)
+        {
+            const Event &e = ring->events[i % capacity];
+            separator();
+            std::fprintf(f, "{\"name\": \"%s\", \"cat\": \"hive\", \"ph\": \"%s\", \"ts\": %.3f, ", e.name,
+                         e.durationNs < 0 ? "i\", \"s\": \"t" : "X", e.startNs / 1000.0);
+            if (e.durationNs >= 0)
+                std::fprintf(f, "\"dur\": %.3f, ", e.durationNs / 1000.0);
+            std::fprintf(f, "\"pid\": 1, \"tid\": %d, \"args\": {", ring->lane);
+            for (int k = 0; k < 2; ++k)
+                if (e.argNames[k])
+                    std::fprintf(f, "%s\"%s\": %d", k > 0 && e.argNames[0] ? ", " : "", e.argNames[k], e.args[k]);
+            std::fputs("}}", f);
+        }
+    }
+    std::fputs("\n]}\n", f);
+    return std::fclose(f) == 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// In-process trace of spans and instant events (TRACE_FILE: ...), exported
+// as Chrome trace-event JSON for chrome://tracing or ui.perfetto.dev. Every
+// thread appends to a fixed-size ring of its own without locking, so a ring
+// holds that thread's latest events. Rings of exited threads go back to a
+// free list for the next thread, which keeps per-tick worker threads from
+// growing the trace. Export only while no other thread is recording.
+class TraceRecorder {
+public:
+    struct Event {
+        const char* name;        // string literals only: events store the pointer
+        const char* argNames[2]; // nullptr: no such argument
+        int32_t args[2];
+        int64_t startNs; // since the recorder was created
+        int64_t durationNs; // < 0: instant event
+    };
+    struct Ring;
+
+    // Installs itself as the active recorder; throws if one already is.
+    explicit TraceRecorder(size_t eventsPerThread);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // the recorder spans and instants go to, or nullptr when tracing is off
+    static TraceRecorder* active() { return current.load(std::memory_order_acquire); }
+    static void instant(const char* name, const char* arg0 = nullptr, int32_t v0 = 0, const char* arg1 = nullptr,
+                        int32_t v1 = 0);
+
+    int64_t now() const;
+    void record(const Event& e); // into the calling thread's ring
+    void nameThisThread(const char* name); // "worker" unless named
+
+    // every retained event as JSON; false when the file cannot be written
+    bool exportJson(const std::string& path) const;
+    // asks the owner to export at its next convenient point; async-signal-safe
+    void requestExport() { exportRequested.store(true, std::memory_order_relaxed); }
+    bool takeExportRequest() { return exportRequested.exchange(false, std::memory_order_relaxed); }
+
+    long long recorded() const; // including overwritten ones
+    long long retained() const;
+
+private:
+    Ring* ringForThisThread();
+    friend struct ThreadRing;
+
+    size_t capacity;
+    uint64_t generation; // tells a thread's cached ring apart from a previous recorder's
+    int64_t originNs;
+    std::vector<std::unique_ptr<Ring>> rings; // registry mutex
+    std::vector<Ring*> freeRings;              // registry mutex
+    std::atomic<bool> exportRequested{false};
+
+    static std::atomic<TraceRecorder*> current;
+};
+
+// Records [construction, destruction) as a span when tracing is on; costs a
+// single load otherwise.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* arg0 = nullptr, int32_t v0 = 0)
+        : rec(TraceRecorder::active())
+    {
+        if (rec)
+        {
+            ev = {name, {arg0, nullptr}, {v0, 0}, rec->now(), 0};
+        }
+    }
+    ~TraceSpan()
+    {
+        if (rec)
+        {
+            ev.durationNs = rec->now() - ev.startNs;
+            rec->record(ev);
+        }
+    }
+    // ends this span and starts `name`, for consecutive phases of one function
+    void next(const char* name)
+    {
+        if (rec)
+        {
+            const int64_t t = rec->now();
+            ev.durationNs = t - ev.startNs;
+            rec->record(ev);
+            ev = {name, {nullptr, nullptr}, {0, 0}, t, 0};
+        }
+    }
+    // the second argument, for results known only at the end of the span
+    void result(const char* arg, int32_t value)
+    {
+        ev.argNames[1] = arg;
+        ev.args[1] = value;
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceRecorder* rec;
+    TraceRecorder::Event ev{};
+};
@@ -1,9 +1,32 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
 #include <unistd.h>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <array>
 
 #include "../src/Simulation.h"
+#include "../src/Errors.h"
+#include "../src/NoiseMapGenerator.h"
+#include "../src/ProceduralMapGenerator.h"
+#include "../src/DispatchService.h"
+#include "../src/Assignment.h"
+#include "../src/FleetRace.h"
+#include "../src/TickArena.h"
+#include "../src/SearchWorkspace.h"
+#include "../src/SharedState.h"
+#include "../src/PairScoring.h"
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #define ASSERT(cond) do { if (!(cond)) { std::cerr << "ASSERT FAILED: " << #cond << " (" << __FILE__ << ":" << __LINE__ << ")\n"; return false; } } while(0)
 
@@ -199,6 +222,1787 @@ bool test_singleton_enforcement() {
     return true;
 }
 
+#ifdef UNIT_TEST
+// Compact textual fingerprint of the mutable state, used to compare runs
+static std::string stateSignature(Simulation &sim) {
+    std::string sig;
+    for (auto &c : sim.getCouriersForTest()) {
+        Vec2 p = c->getPos();
+        sig += c->typeName() + "@" + std::to_string(p.x) + "," + std::to_string(p.y) + " b" + std::to_string(c->getBattery());
+        for (auto *pk : c->getPackages()) sig += " p" + std::to_string(pk->getId());
+        sig += ";";
+    }
+    for (auto &p : sim.getPackagesForTest())
+        sig += std::to_string(p->getId()) + ":" + std::to_string(p->deliveredAt()) + ",";
+    sig += "|pool=" + std::to_string(sim.getPackagePoolForTest().size());
+    return sig;
+}
+#endif
+
+bool test_snapshot_roundtrip_and_fork() {
+    std::string cfg = makeTempPath("cfg_snapshot");
+    writeFile(cfg,
+        "MAP_SIZE: 5 5\n"
+        "MAX_TICKS: 200\n"
+        "DRONES: 2\n"
+        "ROBOTS: 1\n"
+        "SCOOTERS: 1\n"
+        "TOTAL_PACKAGES: 20\n"
+        "SPAWN_FREQUENCY: 2\n"
+    );
+    std::string map = makeTempPath("map_snapshot");
+    writeFile(map,
+        "B..#.\n"
+        ".#.D.\n"
+        "..S..\n"
+        "D#...\n"
+        "...D.\n"
+    );
+    std::string snap = makeTempPath("snapshot");
+
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.seedRngForTest(7);
+    sim.callSpawnCouriersForTest();
+    for (int i = 0; i < 15; ++i) sim.callStepForTest();
+    sim.saveSnapshot(snap);
+
+    // fork shares the map but evolves independently from the same state
+    const int warm = sim.callComputeDistanceForTest({0, 1}, {2, 4}, false);
+    auto branch = sim.fork();
+    ASSERT(Simulation::getInstancePtr() == &sim);
+    ASSERT(stateSignature(*branch) == stateSignature(sim));
+    // planners are shared until the fork queries one
+    ASSERT(branch->plannerSharedForTest({2, 4}));
+    ASSERT(branch->callComputeDistanceForTest({4, 0}, {2, 4}, false) >= 0);
+    ASSERT(!branch->plannerSharedForTest({2, 4}) && !sim.plannerSharedForTest({2, 4}));
+    ASSERT(sim.callComputeDistanceForTest({0, 1}, {2, 4}, false) == warm);
+
+    for (int i = 0; i < 15; ++i) sim.callStepForTest();
+    std::string expected = stateSignature(sim);
+
+    for (int i = 0; i < 15; ++i) branch->callStepForTest();
+    ASSERT(stateSignature(*branch) == expected);
+
+    // restoring the snapshot and replaying gives the same state again
+    sim.loadSnapshot(snap);
+    for (int i = 0; i < 15; ++i) sim.callStepForTest();
+    ASSERT(stateSignature(sim) == expected);
+
+    bool threw = false;
+    writeFile(snap, "not a snapshot");
+    try { sim.loadSnapshot(snap); } catch (const SnapshotError&) { threw = true; }
+    ASSERT(threw);
+#else
+    (void)sim;
+#endif
+    return true;
+}
+
+bool test_lookahead_dispatch() {
+    std::string cfg = makeTempPath("cfg_lookahead");
+    writeFile(cfg,
+        "MAP_SIZE: 5 5\n"
+        "MAX_TICKS: 200\n"
+        "DRONES: 2\n"
+        "ROBOTS: 1\n"
+        "SCOOTERS: 1\n"
+        "TOTAL_PACKAGES: 10\n"
+        "SPAWN_FREQUENCY: 2\n"
+        "LOOKAHEAD_HORIZON: 6\n"
+        "LOOKAHEAD_CANDIDATES: 3\n"
+        "LOOKAHEAD_BUDGET_US: 1000000\n"
+        "LOOKAHEAD_THREADS: 2\n"
+    );
+    std::string map = makeTempPath("map_lookahead");
+    writeFile(map,
+        "B..#.\n"
+        ".#.D.\n"
+        "..S..\n"
+        "D#...\n"
+        "...D.\n"
+    );
+
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.seedRngForTest(3);
+    sim.callSpawnCouriersForTest();
+    for (int i = 0; i < 60; ++i) sim.callStepForTest();
+    int delivered = 0;
+    for (auto &p : sim.getPackagesForTest())
+        if (p->isDelivered()) ++delivered;
+    ASSERT(delivered > 0);
+    ASSERT(sim.getLookaheadBudgetHitsForTest() == 0);
+    // rollouts never touch the real RNG: the same seed replays identically
+    auto replay = sim.fork();
+    sim.callStepForTest();
+    replay->callStepForTest();
+    ASSERT(stateSignature(sim) == stateSignature(*replay));
+
+    // a zero budget degrades to the myopic plan and counts the hit
+    sim.getConfigForTest().lookaheadBudgetUs = 0;
+    sim.callSpawnPackageForTest();
+    auto myopic = sim.fork();
+    myopic->getConfigForTest().lookaheadHorizon = 0;
+    const int hits = sim.getLookaheadBudgetHitsForTest();
+    sim.callStepForTest();
+    myopic->callStepForTest();
+    ASSERT(sim.getLookaheadBudgetHitsForTest() > hits || sim.getPackagePoolForTest().empty());
+    ASSERT(stateSignature(sim) == stateSignature(*myopic));
+#else
+    (void)sim;
+#endif
+    return true;
+}
+
+#ifdef UNIT_TEST
+// Reference ground distance: plain BFS over the current grid
+static int bfsDistance(const std::vector<std::string> &grid, Vec2 a, Vec2 b) {
+    int rows = (int)grid.size(), cols = (int)grid[0].size();
+    if (a.x == b.x && a.y == b.y) return 0;
+    std::vector<int> dist(rows * cols, -1);
+    std::vector<Vec2> q{a};
+    dist[a.x * cols + a.y] = 0;
+    const int dr[4] = {1, -1, 0, 0};
+    const int dc[4] = {0, 0, 1, -1};
+    for (size_t h = 0; h < q.size(); ++h) {
+        Vec2 p = q[h];
+        for (int k = 0; k < 4; ++k) {
+            int nr = p.x + dr[k], nc = p.y + dc[k];
+            if (nr < 0 || nc < 0 || nr >= rows || nc >= cols) continue;
+            if (dist[nr * cols + nc] >= 0 || grid[nr][nc] == '#') continue;
+            dist[nr * cols + nc] = dist[p.x * cols + p.y] + 1;
+            if (nr == b.x && nc == b.y) return dist[nr * cols + nc];
+            q.push_back({nr, nc});
+        }
+    }
+    return -1;
+}
+#endif
+
+bool test_dynamic_obstacles_incremental_repair() {
+    std::string cfg = makeTempPath("cfg_dynamic");
+    writeFile(cfg,
+        "MAP_SIZE: 3 6\n"
+        "MAX_TICKS: 100\n"
+        "DRONES: 0\n"
+        "ROBOTS: 0\n"
+        "SCOOTERS: 1\n"
+        "TOTAL_PACKAGES: 1\n"
+        "SPAWN_FREQUENCY: 1000\n"
+    );
+    std::string map = makeTempPath("map_dynamic");
+    writeFile(map,
+        "B.....\n"
+        "......\n"
+        ".....D\n"
+    );
+
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.callSpawnCouriersForTest();
+    sim.seedRngForTest(1);
+    sim.callSpawnPackageForTest();
+    sim.callStepForTest();
+    auto &couriers = sim.getCouriersForTest();
+    ASSERT(!couriers[0]->getPackages().empty());
+    ASSERT(couriers[0]->getPos().x == 2 && couriers[0]->getPos().y == 0);
+
+    // a closure away from the route leaves it alone, one on the route repairs it
+    ASSERT(!sim.setCellBlocked({2, 5}, true)); // clients cannot be closed
+    ASSERT(sim.setCellBlocked({0, 5}, true));
+    ASSERT(sim.getRouteRepairsForTest() == 0);
+    ASSERT(sim.setCellBlocked({2, 3}, true));
+    ASSERT(sim.getRouteRepairsForTest() == 1);
+    for (int i = 0; i < 6 && !sim.getPackagesForTest()[0]->isDelivered(); ++i)
+        sim.callStepForTest();
+    ASSERT(sim.getPackagesForTest()[0]->isDelivered());
+
+    // incremental distances agree with a fresh BFS through random toggles
+    std::mt19937 toggles(99);
+    std::uniform_int_distribution<int> rx(0, 2), ry(0, 5);
+    for (int i = 0; i < 200; ++i) {
+        Vec2 cell{rx(toggles), ry(toggles)};
+        char c = sim.getMapForTest().grid[cell.x][cell.y];
+        sim.setCellBlocked(cell, c == '.');
+        for (Vec2 a : {Vec2{0, 0}, Vec2{1, 2}, Vec2{2, 4}}) {
+            for (Vec2 b : {Vec2{0, 0}, Vec2{2, 5}}) {
+                int expected = sim.getMapForTest().grid[b.x][b.y] == '#' ? -1 : bfsDistance(sim.getMapForTest().grid, a, b);
+                ASSERT(sim.callComputeDistanceForTest(a, b, false) == expected);
+            }
+        }
+    }
+#else
+    (void)sim;
+#endif
+    return true;
+}
+
+bool test_noise_generator_deterministic_and_connected() {
+    Config c;
+    c.rows = 150;
+    c.cols = 170;
+    c.clientsCount = 40;
+    c.maxStations = 6;
+
+    std::vector<std::string> g1, g2;
+    Vec2 b1{}, b2{};
+    std::vector<Vec2> c1, c2, s1, s2;
+    Config cfg1 = c, cfg2 = c;
+    CounterRng r1(2024, RngStream::MapGeneration), r2(2024, RngStream::MapGeneration);
+    NoiseMapGenerator(10, 2, 0.3, 1).generate(cfg1, r1, g1, b1, c1, s1);
+    NoiseMapGenerator(10, 2, 0.3, 3).generate(cfg2, r2, g2, b2, c2, s2);
+    ASSERT(g1 == g2); // thread count does not change the map
+    ASSERT(b1.x == b2.x && b1.y == b2.y);
+    ASSERT(c1.size() == 40 && s1.size() == 6);
+    ASSERT(g1[b1.x][b1.y] == 'B');
+
+    int walls = 0;
+    for (auto &row : g1) for (char ch : row) walls += (ch == '#');
+    ASSERT(walls > c.rows * c.cols / 4); // buildings, not salt-and-pepper noise
+
+    // a shortfall on a tiny map leaves the requested counts alone for retries
+    Config tiny = c;
+    tiny.rows = 6;
+    tiny.cols = 6;
+    CounterRng r3(2024, RngStream::MapGeneration);
+    NoiseMapGenerator(10, 2, 0.3, 1).generate(tiny, r3, g1, b1, c1, s1);
+    ASSERT(c1.size() < 40 && tiny.clientsCount == 40 && tiny.maxStations == 6);
+
+
+    std::string cfgPath = makeTempPath("cfg_noise");
+    writeFile(cfgPath,
+        "MAP_SIZE: 150 170\n"
+        "CLIENTS_COUNT: 40\n"
+        "MAX_STATIONS: 6\n"
+        "MAP_GENERATOR: NOISE\n"
+    );
+    Simulation sim(cfgPath);
+    sim.loadConfig();
+    sim.generateMap(); // throws if any client or station is unreachable
+#ifdef UNIT_TEST
+    ASSERT(sim.getMapForTest().clients.size() == 40);
+#endif
+    return true;
+}
+
+bool test_procedural_map_connected_by_construction() {
+    Config c;
+    c.rows = 60;
+    c.cols = 80;
+    c.clientsCount = 300;
+    c.maxStations = 20;
+    for (double wallProb : {0.3, 0.6, 0.9}) {
+        std::vector<std::string> grid;
+        Vec2 base{};
+        std::vector<Vec2> clients, stations;
+        CounterRng rng(11, RngStream::MapGeneration);
+        ProceduralMapGenerator gen(wallProb);
+        ASSERT(gen.guaranteesConnectivity());
+        gen.generate(c, rng, grid, base, clients, stations);
+        ASSERT((int)clients.size() == c.clientsCount);
+        ASSERT((int)stations.size() == c.maxStations);
+#ifdef UNIT_TEST
+        for (const Vec2 &p : clients) ASSERT(bfsDistance(grid, base, p) >= 0);
+        for (const Vec2 &p : stations) ASSERT(bfsDistance(grid, base, p) >= 0);
+#endif
+    }
+    return true;
+}
+
+bool test_telemetry_csv_and_binary() {
+    std::string cfg = makeTempPath("cfg_telemetry");
+    std::string csv = makeTempPath("telemetry_csv");
+    std::string bin = makeTempPath("telemetry_bin");
+    std::string map = makeTempPath("map_telemetry");
+    writeFile(map,
+        "B....\n"
+        "..D..\n"
+        ".....\n"
+    );
+    for (const std::string &format : {std::string("CSV"), std::string("BINARY")}) {
+        writeFile(cfg,
+            "MAP_SIZE: 3 5\n"
+            "MAX_TICKS: 100\n"
+            "DRONES: 1\n"
+            "ROBOTS: 1\n"
+            "TOTAL_PACKAGES: 5\n"
+            "SPAWN_FREQUENCY: 2\n"
+            "TELEMETRY_INTERVAL: 3\n"
+            "TELEMETRY_FORMAT: " + format + "\n"
+            "TELEMETRY_FILE: " + (format == "CSV" ? csv : bin) + "\n"
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+        sim.seedRngForTest(5);
+        sim.callSpawnCouriersForTest();
+        sim.callOpenTelemetryForTest();
+        for (int i = 0; i < 30; ++i) sim.callStepForTest();
+        sim.closeTelemetryForTest();
+#endif
+    }
+#ifdef UNIT_TEST
+    const size_t ncols = TelemetryWriter::columnNames().size();
+    std::ifstream in(csv);
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(in, line)) lines.push_back(line);
+    ASSERT(lines.size() == 11); // header + ticks 3, 6, ..., 30
+    ASSERT(lines[0].rfind("tick,waiting,", 0) == 0);
+    ASSERT(lines[1].rfind("3,", 0) == 0);
+    ASSERT((size_t)std::count(lines[5].begin(), lines[5].end(), ',') == ncols - 1);
+
+    std::ifstream bi(bin, std::ios::binary);
+    char magic[8];
+    bi.read(magic, 8);
+    ASSERT(std::string(magic, 8) == "HIVETLM1");
+    uint32_t cols = 0;
+    bi.read(reinterpret_cast<char*>(&cols), 4);
+    ASSERT(cols == ncols);
+    for (uint32_t c = 0; c < cols; ++c) {
+        uint32_t len = 0;
+        bi.read(reinterpret_cast<char*>(&len), 4);
+        bi.seekg(len, std::ios::cur);
+    }
+    uint32_t rows = 0;
+    bi.read(reinterpret_cast<char*>(&rows), 4);
+    ASSERT(rows == 10);
+    std::vector<int32_t> ticks(rows);
+    bi.read(reinterpret_cast<char*>(ticks.data()), rows * 4);
+    ASSERT(bi && ticks[0] == 3 && ticks[9] == 30);
+
+    // a write failure mid-run disables telemetry instead of ending the run
+    if (std::ifstream("/dev/full")) {
+        writeFile(cfg,
+            "MAP_SIZE: 3 5\n"
+            "DRONES: 1\n"
+            "TOTAL_PACKAGES: 5\n"
+            "TELEMETRY_FILE: /dev/full\n"
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.loadMapFromFile(map);
+        sim.callSpawnCouriersForTest();
+        sim.callOpenTelemetryForTest();
+        for (int i = 0; i < 5; ++i) sim.callStepForTest();
+        bool threw = false;
+        try { sim.closeTelemetryForTest(); } catch (...) { threw = true; }
+        ASSERT(!threw && !sim.hasTelemetryForTest());
+        sim.callStepForTest();
+    }
+#endif
+    return true;
+}
+
+bool test_kpi_ledger_matches_recount() {
+    std::string cfg = makeTempPath("cfg_ledger");
+    std::string map = makeTempPath("map_ledger");
+    writeFile(map,
+        "B...D\n"
+        ".#.#.\n"
+        "D...S\n"
+    );
+    writeFile(cfg,
+        "MAP_SIZE: 3 5\n"
+        "MAX_TICKS: 400\n"
+        "DRONES: 1\n"
+        "ROBOTS: 1\n"
+        "SCOOTERS: 1\n"
+        "TOTAL_PACKAGES: 8\n"
+        "SPAWN_FREQUENCY: 3\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.seedRngForTest(11);
+    sim.callSpawnCouriersForTest();
+    const Vec2 base{0, 0};
+    for (int t = 0; t < 400 && !sim.isAllDelivered(); ++t) {
+        sim.callStepForTest();
+        // the ledger must agree with a full rescan after every tick
+        int delivered = 0, late = 0, active = 0, carrying = 0;
+        for (const auto &p : sim.getPackagesForTest()) {
+            if (!p->isDelivered()) continue;
+            ++delivered;
+            if (p->deliveredAt() > p->getDeadline()) ++late;
+        }
+        for (const auto &c : sim.getCouriersForTest()) {
+            KpiLedger::CourierStatus s = KpiLedger::statusOf(*c, base);
+            active += s.active;
+            carrying += s.carrying;
+        }
+        const KpiLedger &l = sim.getLedger();
+        ASSERT(l.spawned == (int)sim.getPackagesForTest().size());
+        ASSERT(l.assigned == l.spawned - (int)sim.getPackagePoolForTest().size());
+        ASSERT(l.delivered == delivered && l.deliveredLate == late);
+        ASSERT(l.activeCouriers == active && l.carryingCouriers == carrying);
+    }
+    // the stop condition comes from the ledger, not from rendering
+    ASSERT(sim.isAllDelivered());
+    ASSERT(sim.getLedger().delivered == 8 && sim.getLedger().lost() == 0);
+#endif
+    return true;
+}
+
+bool test_dispatch_rule_table() {
+    RuleTable t;
+    ASSERT(t[CourierKind::Drone].minReward == 300);
+    ASSERT(t[CourierKind::Robot].resolvedMaxDistance(30) == 10);
+    {
+        std::istringstream in("ROBOT MAX_DISTANCE ROWS/5");
+        ASSERT(t.parse(in) && t[CourierKind::Robot].resolvedMaxDistance(30) == 6);
+    }
+    {
+        std::istringstream in("TRUCK MIN_REWARD 10");
+        ASSERT(!t.parse(in));
+        std::istringstream bad("SCOOTER BATTERY_RESERVE 150");
+        ASSERT(!t.parse(bad) && t[CourierKind::Scooter].batteryReservePct == 0);
+    }
+
+    std::string map = makeTempPath("map_rules");
+    writeFile(map,
+        "B....\n"
+        "..D..\n"
+        ".....\n"
+    );
+    // a cheap package: refused by the default drone rule, taken once it is off
+    for (const std::string &rule : {std::string(""), std::string("RULE: DRONE MIN_REWARD OFF\n")}) {
+        std::string cfg = makeTempPath("cfg_rules");
+        writeFile(cfg,
+            "MAP_SIZE: 3 5\n"
+            "MAX_TICKS: 100\n"
+            "DRONES: 1\n"
+            "ROBOTS: 0\n"
+            "SCOOTERS: 0\n"
+            "TOTAL_PACKAGES: 1\n"
+            "SPAWN_FREQUENCY: 1000\n" + rule
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+        sim.callSpawnCouriersForTest();
+        auto &packages = sim.getPackagesForTest();
+        packages.push_back(std::make_unique<Package>(0, 1, 2, 150, 50));
+        sim.getPackagePoolForTest().push_back(packages.back().get());
+        sim.callHiveMindDispatchForTest();
+        ASSERT(sim.getPackagePoolForTest().size() == (rule.empty() ? 1u : 0u));
+#endif
+    }
+
+    // the robot's ROWS/3 range follows the loaded map (9 rows), not MAP_SIZE
+    std::string wide = makeTempPath("map_rules_rows");
+    writeFile(wide,
+        "B.........D.\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+        "............\n"
+    );
+    for (bool viaGenerator : {false, true}) {
+        std::string cfg = makeTempPath("cfg_rules_rows");
+        writeFile(cfg,
+            "MAP_SIZE: 60 60\n"
+            "DRONES: 0\n"
+            "ROBOTS: 1\n"
+            "SCOOTERS: 0\n"
+            "TOTAL_PACKAGES: 1\n"
+            "SPAWN_FREQUENCY: 1000\n" + (viaGenerator ? "MAP_FILE: " + wide + "\n" : std::string())
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        if (viaGenerator)
+            sim.generateMap();
+        else
+            sim.loadMapFromFile(wide);
+#ifdef UNIT_TEST
+        sim.callSpawnCouriersForTest();
+        auto &packages = sim.getPackagesForTest();
+        packages.push_back(std::make_unique<Package>(0, 0, 10, 500, 100));
+        sim.getPackagePoolForTest().push_back(packages.back().get());
+        sim.callHiveMindDispatchForTest();
+        ASSERT(sim.getPackagePoolForTest().size() == 1u); // 10 cells > 9 / 3
+#endif
+    }
+    return true;
+}
+
+bool test_charger_field_and_station_stop() {
+    std::string map = makeTempPath("map_chargers");
+    writeFile(map,
+        "B....S....D\n"
+        ".###.#.##..\n"
+        "...#...#S..\n"
+    );
+    std::string cfg = makeTempPath("cfg_chargers");
+    writeFile(cfg,
+        "MAP_SIZE: 3 11\n"
+        "MAX_TICKS: 100\n"
+        "DRONES: 0\n"
+        "ROBOTS: 1\n"
+        "SCOOTERS: 0\n"
+        "TOTAL_PACKAGES: 0\n"
+        "SPAWN_FREQUENCY: 1000\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    // the field agrees with brute force for every cell, on the ground and in the air
+    const auto &grid = sim.getMapForTest().grid;
+    const ChargerField &field = sim.getChargersForTest();
+    ASSERT(field.chargers().size() == 3);
+    for (int x = 0; x < 3; ++x) {
+        for (int y = 0; y < 11; ++y) {
+            int ground = -1, air = -1;
+            for (const Vec2 &s : field.chargers()) {
+                int g = bfsDistance(grid, {x, y}, s);
+                if (g >= 0 && (ground < 0 || g < ground)) ground = g;
+                int a = std::abs(x - s.x) + std::abs(y - s.y);
+                if (air < 0 || a < air) air = a;
+            }
+            ASSERT(field.distance({x, y}, false) == ground);
+            ASSERT(field.distance({x, y}, true) == air);
+            if (ground >= 0) {
+                Vec2 n = field.nearest({x, y}, false);
+                ASSERT(bfsDistance(grid, {x, y}, n) == ground);
+            }
+        }
+    }
+
+    // A robot too low on battery to deliver and reach a charger is still
+    // dispatched, with a stop at the station on the way, and survives.
+    sim.callSpawnCouriersForTest();
+    auto &robot = sim.getCouriersForTest()[0];
+    robot->setPosForTest({0, 3});
+    robot->setBatteryForTest(10);
+    auto &packages = sim.getPackagesForTest();
+    packages.push_back(std::make_unique<Package>(0, 0, 10, 500, 100));
+    sim.getPackagePoolForTest().push_back(packages.back().get());
+    sim.callHiveMindDispatchForTest();
+    ASSERT(sim.getPackagePoolForTest().empty());
+    bool visitedStation = false;
+    for (int t = 0; t < 40 && !packages[0]->isDelivered(); ++t) {
+        sim.callStepForTest();
+        visitedStation |= robot->getPos().x == 0 && robot->getPos().y == 5;
+        ASSERT(!robot->isDead());
+    }
+    ASSERT(packages[0]->isDelivered() && visitedStation);
+    ASSERT(sim.getDeadAgentsForTest() == 0);
+#endif
+    return true;
+}
+
+bool test_event_engine_matches_tick_engine() {
+    std::string map = makeTempPath("map_event");
+    writeFile(map,
+        "B...#....D\n"
+        ".#..#.##..\n"
+        "...S...#.D\n"
+        "D.#....S..\n"
+    );
+    std::string sigs[2];
+    long long profit[2] = {0, 0};
+    int advances[2] = {0, 0};
+    for (int engine = 0; engine < 2; ++engine) {
+        std::string cfg = makeTempPath("cfg_event");
+        writeFile(cfg,
+            "MAP_SIZE: 4 10\n"
+            "MAX_TICKS: 700\n"
+            "DRONES: 1\n"
+            "ROBOTS: 1\n"
+            "SCOOTERS: 1\n"
+            "TOTAL_PACKAGES: 9\n"
+            "SPAWN_FREQUENCY: 60\n"
+            "SEED: 9\n"
+            "RULE: DRONE MIN_REWARD OFF\n"
+            "RULE: ROBOT MAX_DISTANCE OFF\n"
+            "ENGINE: " + std::string(engine ? "EVENT" : "TICK") + "\n"
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+        sim.seedRngForTest(9);
+        sim.callSpawnCouriersForTest();
+        while (sim.getCurrentTick() < 700 && !sim.isAllDelivered()) {
+            sim.callAdvanceForTest();
+            ++advances[engine];
+        }
+        sigs[engine] = stateSignature(sim) + "@" + std::to_string(sim.getCurrentTick());
+        profit[engine] = sim.getLedger().finalProfit();
+        if (engine)
+            ASSERT(sim.getSkippedTicksForTest() > 0);
+#endif
+    }
+#ifdef UNIT_TEST
+    ASSERT(sigs[0] == sigs[1]);
+    ASSERT(profit[0] == profit[1]);
+    ASSERT(advances[1] * 2 < advances[0]); // sparse demand: most ticks are skipped
+
+    // a generated map with default rules, where couriers recharge at the
+    // base while holding a package: the engines must agree tick for tick
+    std::vector<std::pair<int, std::string>> trace[2];
+    for (int engine = 0; engine < 2; ++engine) {
+        std::string cfg = makeTempPath("cfg_event_generated");
+        writeFile(cfg,
+            "MAP_SIZE: 20 20\n"
+            "MAX_TICKS: 400\n"
+            "TOTAL_PACKAGES: 30\n"
+            "SPAWN_FREQUENCY: 10\n"
+            "SEED: 1\n"
+            "ENGINE: " + std::string(engine ? "EVENT" : "TICK") + "\n"
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.generateMap();
+        sim.callSpawnCouriersForTest();
+        while (sim.getCurrentTick() < 400 && !sim.isAllDelivered()) {
+            sim.callAdvanceForTest();
+            trace[engine].push_back({sim.getCurrentTick(), stateSignature(sim)});
+        }
+    }
+    size_t j = 0;
+    for (const auto &point : trace[1]) {
+        while (j < trace[0].size() && trace[0][j].first < point.first) ++j;
+        ASSERT(j < trace[0].size() && trace[0][j] == point);
+    }
+#endif
+    return true;
+}
+
+bool test_order_queue_mpsc() {
+    // single-threaded: the ring rejects once full and recycles slots
+    OrderQueue q(5);
+    ASSERT(q.capacity() == 8);
+    for (int i = 0; i < 8; ++i)
+        ASSERT(q.tryPush({i, 0, 100, 10}));
+    ASSERT(!q.tryPush({9, 0, 100, 10}));
+    ASSERT(q.depth() == 8 && q.highWater() == 8 && q.rejected() == 1);
+    OrderRequest o;
+    ASSERT(q.tryPop(o) && o.destX == 0);
+    ASSERT(q.tryPush({8, 0, 100, 10}));
+    for (int i = 1; i <= 8; ++i)
+        ASSERT(q.tryPop(o) && o.destX == i);
+    ASSERT(!q.tryPop(o) && q.depth() == 0);
+
+    // a consumer draining as fast as producers push: the depth a producer
+    // measures after its push can be stale, but never beyond the ring
+    {
+        OrderQueue fast(4);
+        std::atomic<bool> stop{false};
+        std::thread consumer([&] {
+            OrderRequest r;
+            while (!stop)
+                fast.tryPop(r);
+        });
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 3; ++t)
+            producers.emplace_back([&] {
+                for (int i = 0; i < 20000; ++i)
+                    fast.tryPush({1, 1, 100, 10});
+            });
+        for (auto &th : producers)
+            th.join();
+        stop = true;
+        consumer.join();
+        ASSERT(fast.highWater() >= 1 && fast.highWater() <= fast.capacity());
+    }
+
+    // producers race the simulation thread; every accepted order becomes a
+    // package exactly once, apart from the deliberately invalid ones
+    std::string map = makeTempPath("map_orders");
+    writeFile(map,
+        "B...#....D\n"
+        ".#..#.##..\n"
+        "...S...#.D\n"
+        "D.#....S..\n"
+    );
+    std::string cfg = makeTempPath("cfg_orders");
+    writeFile(cfg,
+        "MAP_SIZE: 4 10\n"
+        "MAX_TICKS: 100000\n"
+        "TOTAL_PACKAGES: 0\n"
+        "ORDER_QUEUE_CAPACITY: 32\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.callSpawnCouriersForTest();
+    OrderQueue &orders = sim.orderQueue();
+    ASSERT(orders.capacity() == 32);
+    const int producers = 4, perProducer = 300;
+    std::atomic<int> done{0};
+    std::atomic<int> pushedInvalid{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < perProducer; ++i) {
+                OrderRequest req{2 + (i % 2), 9 - 9 * ((i / 2) % 2), 200 + t, 15};
+                if (i % 50 == 0)
+                    req.destX = 0, req.destY = 4; // a wall
+                while (!orders.tryPush(req))
+                    std::this_thread::yield(); // rejected: back off and retry
+                if (i % 50 == 0)
+                    ++pushedInvalid;
+            }
+            ++done;
+        });
+    }
+    while (done.load() < producers)
+        sim.callStepForTest();
+    for (auto &th : threads)
+        th.join();
+    sim.callStepForTest(); // drain the tail
+    ASSERT(orders.depth() == 0);
+    ASSERT(orders.accepted() == (uint64_t)producers * perProducer);
+    ASSERT(orders.highWater() <= orders.capacity());
+    auto &pkgs = sim.getPackagesForTest();
+    ASSERT((int)pkgs.size() == producers * perProducer - pushedInvalid.load());
+    ASSERT(sim.getLedger().spawned == (int)pkgs.size());
+    for (size_t i = 0; i < pkgs.size(); ++i)
+        ASSERT(pkgs[i]->getId() == (int)i);
+#endif
+    return true;
+}
+
+// one request line over a Unix socket, returning the reply line
+static std::string serviceRequest(int fd, const std::string &line) {
+    std::string msg = line + "\n";
+    if (send(fd, msg.data(), msg.size(), MSG_NOSIGNAL) != (ssize_t)msg.size())
+        return "";
+    std::string reply;
+    char ch;
+    while (recv(fd, &ch, 1, 0) == 1 && ch != '\n')
+        reply += ch;
+    return reply;
+}
+
+bool test_dispatch_service_socket() {
+    std::string map = makeTempPath("map_service");
+    writeFile(map,
+        "B...#....D\n"
+        ".#..#.##..\n"
+        "...S...#.D\n"
+        "D.#....S..\n"
+    );
+    std::string cfg = makeTempPath("cfg_service");
+    writeFile(cfg,
+        "MAP_SIZE: 4 10\n"
+        "TOTAL_PACKAGES: 0\n"
+        "ORDER_QUEUE_CAPACITY: 2\n"
+        "ENGINE: EVENT\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.callSpawnCouriersForTest();
+#endif
+    std::string sock = "/tmp/hive_service_" + std::to_string(getpid()) + ".sock";
+    DispatchService service(sim, sock, 5);
+    std::thread server([&] { service.run(); });
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, sock.c_str(), sizeof(addr.sun_path) - 1);
+    bool connected = connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0;
+    std::string clients = connected ? serviceRequest(fd, "CLIENTS") : "";
+    std::string bad = connected ? serviceRequest(fd, "SUBMIT 1 2") : "";
+    std::string unknown = connected ? serviceRequest(fd, "FROB") : "";
+    // let a few idle ticks pass before any order arrives
+    for (int tries = 0; connected && tries < 400; ++tries) {
+        std::string status = serviceRequest(fd, "STATUS");
+        if (status.rfind("STATUS tick=", 0) == 0 && std::atoi(status.c_str() + 12) >= 3)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    int queued = 0;
+    for (int i = 0; connected && i < 6; ++i) {
+        // the tiny queue only drains on ticks: retry rejected orders
+        std::string reply = serviceRequest(fd, "SUBMIT 0 9 500 30");
+        if (reply == "QUEUED")
+            ++queued;
+        else {
+            --i;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    std::string status, latency;
+    for (int tries = 0; connected && tries < 400; ++tries) {
+        latency = serviceRequest(fd, "LATENCY");
+        if (latency.rfind("LATENCY count=6 ", 0) == 0)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    status = connected ? serviceRequest(fd, "STATUS") : "";
+    std::string bye = connected ? serviceRequest(fd, "SHUTDOWN") : "";
+    if (!connected)
+        service.stop();
+    server.join();
+    close(fd);
+
+    ASSERT(connected);
+    ASSERT(clients == "CLIENTS 3 0 9 2 9 3 0");
+    ASSERT(bad.rfind("ERR usage", 0) == 0);
+    ASSERT(unknown.rfind("ERR unknown", 0) == 0);
+    ASSERT(queued == 6);
+    ASSERT(latency.rfind("LATENCY count=6 ", 0) == 0);
+    ASSERT(sim.getAssignLatency().percentile(0.5) > 0);
+    ASSERT(status.find(" assigned=6") != std::string::npos);
+    ASSERT(status.find("/2 ") != std::string::npos);
+    ASSERT(bye == "BYE");
+    ASSERT(sim.getLedger().spawned == 6);
+#ifdef UNIT_TEST
+    // service ticks go through advance(), so idle ones use the event engine
+    ASSERT(sim.getSkippedTicksForTest() > 0);
+#endif
+    return true;
+}
+
+// 1 if two live ground couriers stand on the same road cell
+static int sharedGroundCells(Simulation &sim) {
+#ifdef UNIT_TEST
+    const auto &grid = sim.getMapForTest().grid;
+    std::map<std::pair<int, int>, int> at;
+    for (auto &c : sim.getCouriersForTest()) {
+        if (c->isDead() || c->canFly())
+            continue;
+        Vec2 p = c->getPos();
+        if (grid[p.x][p.y] != '.')
+            continue; // base, stations and doorsteps have no capacity limit
+        if (++at[{p.x, p.y}] == 2)
+            return 1;
+    }
+#else
+    (void)sim;
+#endif
+    return 0;
+}
+
+bool test_cooperative_reservations() {
+    // the table itself: colliding keys, backward-shift erase, expiry
+    ReservationTable table;
+    for (int t = 0; t < 50; ++t)
+        for (int cell = 0; cell < 40; ++cell)
+            ASSERT(table.reserve(cell, t, (cell + t) % 7));
+    ASSERT(table.size() == 2000);
+    ASSERT(!table.reserve(3, 4, 99) && table.holder(3, 4) == 0);
+    for (int t = 0; t < 50; t += 2)
+        for (int cell = 0; cell < 40; ++cell)
+            table.release(cell, t, (cell + t) % 7);
+    ASSERT(table.size() == 1000);
+    for (int t = 0; t < 50; ++t)
+        for (int cell = 0; cell < 40; ++cell)
+            ASSERT(table.holder(cell, t) == (t % 2 ? (cell + t) % 7 : ReservationTable::none));
+    table.expireBefore(25);
+    ASSERT(table.size() == 520 && table.holder(1, 23) == ReservationTable::none && table.holder(1, 25) == 5);
+
+    // a long single-lane road with a few passing bays: without reservations
+    // ground couriers overlap, with them they never share a road cell
+    std::string map = makeTempPath("map_coop");
+    writeFile(map,
+        "B.........D\n"
+        ".#.#.##.#.#\n"
+        "..S..D....D\n"
+    );
+    int shared[2] = {0, 0};
+    int delivered[2] = {0, 0};
+    for (int cap = 0; cap < 2; ++cap) {
+        std::string cfg = makeTempPath("cfg_coop");
+        writeFile(cfg,
+            "MAP_SIZE: 3 11\n"
+            "DRONES: 0\n"
+            "ROBOTS: 4\n"
+            "SCOOTERS: 3\n"
+            "TOTAL_PACKAGES: 60\n"
+            "SPAWN_FREQUENCY: 2\n"
+            "RULE: ROBOT MAX_DISTANCE OFF\n"
+            "ROAD_CAPACITY: " + std::to_string(cap) + "\n"
+            "WHCA_WINDOW: 6\n"
+        );
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+        sim.seedRngForTest(5);
+        sim.callSpawnCouriersForTest();
+        for (int t = 0; t < 400 && !sim.isAllDelivered(); ++t) {
+            sim.callStepForTest();
+            shared[cap] += sharedGroundCells(sim);
+        }
+        delivered[cap] = sim.getLedger().delivered;
+        if (cap)
+            ASSERT(sim.getReservationConflictsForTest() == 0);
+#endif
+    }
+#ifdef UNIT_TEST
+    ASSERT(shared[0] > 0);
+    ASSERT(shared[1] == 0);
+    ASSERT(delivered[1] > 40);
+#endif
+    (void)delivered;
+    return true;
+}
+
+bool test_cooperative_closed_via_replans() {
+    // scooters move two cells a tick; closing the cell a planned move passes
+    // through must send the scooter around it, not through the new wall
+    std::string map = makeTempPath("map_coop_via");
+    writeFile(map,
+        "B.........D\n"
+        "...........\n"
+        "..S..D....D\n"
+    );
+    std::string cfg = makeTempPath("cfg_coop_via");
+    writeFile(cfg,
+        "MAP_SIZE: 3 11\n"
+        "DRONES: 0\n"
+        "ROBOTS: 0\n"
+        "SCOOTERS: 3\n"
+        "TOTAL_PACKAGES: 20\n"
+        "SPAWN_FREQUENCY: 2\n"
+        "ROAD_CAPACITY: 1\n"
+        "WHCA_WINDOW: 6\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.seedRngForTest(9);
+    sim.callSpawnCouriersForTest();
+    auto &couriers = sim.getCouriersForTest();
+    int closed = 0, checked = 0;
+    for (int t = 0; t < 300 && !sim.isAllDelivered(); ++t) {
+        int watched = -1;
+        for (size_t ci = 0; ci < couriers.size() && watched < 0; ++ci) {
+            Vec2 next, via;
+            if (!sim.cooperativePlanAtForTest(ci, sim.getCurrentTick() + 1, next, via) || via.x < 0)
+                continue;
+            bool occupied = false;
+            for (auto &c : couriers)
+                occupied |= c->getPos().x == via.x && c->getPos().y == via.y;
+            if (!occupied && sim.setCellBlocked(via, true)) {
+                watched = (int)ci;
+                ++closed;
+            }
+        }
+        sim.callStepForTest();
+        if (watched < 0)
+            continue;
+        // wherever it went this tick, it did not pass through a wall
+        Vec2 cell, via;
+        const Vec2 pos = couriers[watched]->getPos();
+        if (sim.cooperativePlanAtForTest(watched, sim.getCurrentTick(), cell, via) && cell.x == pos.x && cell.y == pos.y) {
+            ASSERT(via.x < 0 || sim.getMapForTest().grid[via.x][via.y] != '#');
+            ++checked;
+        }
+        // reopen it so the road keeps its passing room
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 11; ++c)
+                if (sim.getMapForTest().grid[r][c] == '#')
+                    sim.setCellBlocked({r, c}, false);
+    }
+    ASSERT(closed > 0 && checked > 0);
+#endif
+    return true;
+}
+
+bool test_anytime_dispatch_budget() {
+    // the solver stages on a random matrix with dummy columns
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> price(-900, 300);
+    const int n = 40, real = 25;
+    std::vector<long long> cells((size_t)n * n, 0);
+    const CostMatrix a{cells.data(), n};
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < real; ++j)
+            a[i][j] = (i * 7 + j) % 11 == 0 ? (long long)1e12 : price(rng);
+    std::vector<int> exact, quick;
+    ASSERT(hungarianAssign(a, exact));
+    ASSERT(greedyAssign(a, quick, Deadline::max()));
+    const long long greedyCost = assignmentCost(a, quick);
+    ASSERT(improveAssignment(a, quick, Deadline::max()));
+    ASSERT(assignmentCost(a, quick) <= greedyCost);
+    ASSERT(assignmentCost(a, exact) <= assignmentCost(a, quick));
+    std::vector<char> seen(n, false);
+    for (int j : quick) {
+        ASSERT(j >= 0 && !seen[j]);
+        seen[j] = true;
+    }
+    const Deadline past = std::chrono::steady_clock::now();
+    std::vector<int> untouched{1, 2, 3};
+    ASSERT(!hungarianAssign(a, untouched, past) && untouched.size() == 3);
+    ASSERT(!greedyAssign(a, quick, past));
+
+    // a spike far larger than the budget: the round is cut short, reported,
+    // and whatever it commits stays consistent with the pool
+    std::string cfg = makeTempPath("cfg_budget");
+    writeFile(cfg,
+        "MAP_SIZE: 30 30\n"
+        "TOTAL_PACKAGES: 400\n"
+        "DISPATCH_BUDGET_US: 1\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.setMapGenerator(std::make_unique<ProceduralMapGenerator>());
+    sim.generateMap();
+#ifdef UNIT_TEST
+    sim.seedRngForTest(4);
+    sim.callSpawnCouriersForTest();
+    for (int i = 0; i < 400; ++i)
+        sim.callSpawnPackageForTest();
+    int assigned = 0;
+    for (int t = 0; t < 30; ++t) {
+        sim.callStepForTest();
+        assigned = sim.getLedger().assigned;
+        ASSERT((int)sim.getPackagePoolForTest().size() == 400 - assigned);
+    }
+    ASSERT(sim.getDispatchBudgetHitsForTest() > 0);
+
+    // a generous budget finishes the exact solve every round
+    sim.getConfigForTest().dispatchBudgetUs = 10000000;
+    const int hits = sim.getDispatchBudgetHitsForTest();
+    sim.callStepForTest();
+    ASSERT(sim.getDispatchBudgetHitsForTest() == hits);
+    ASSERT(sim.getLedger().assigned >= assigned);
+#endif
+    return true;
+}
+
+// walls the client off on its first `bad` maps, then leaves it reachable
+class FlakyMapGenerator : public IMapGenerator {
+public:
+    FlakyMapGenerator(int bad, bool regenerate) : bad(bad), regenerate(regenerate) {}
+    void generate(Config& cfg, CounterRng&, std::vector<std::string>& grid,
+                  Vec2& basePos, std::vector<Vec2>& clients, std::vector<Vec2>& stations) override {
+        cfg.rows = 3;
+        cfg.cols = 5;
+        grid = {"B.#..", "..#.D", "..#.."};
+        if (calls++ >= bad)
+            grid[1][2] = '.';
+        basePos = {0, 0};
+        clients = {{1, 4}};
+        stations.clear();
+    }
+    bool canRegenerate() const override { return regenerate; }
+    int calls = 0;
+private:
+    int bad;
+    bool regenerate;
+};
+
+bool test_map_regeneration_follows_generator() {
+    std::string cfg = makeTempPath("cfg_regen");
+    writeFile(cfg, "MAP_SIZE: 3 5\n");
+    {
+        Simulation sim(cfg);
+        sim.loadConfig();
+        auto gen = std::make_unique<FlakyMapGenerator>(2, true);
+        FlakyMapGenerator *flaky = gen.get();
+        sim.setMapGenerator(std::move(gen));
+        sim.generateMap();
+        ASSERT(flaky->calls == 3);
+    }
+    {
+        Simulation sim(cfg);
+        sim.loadConfig();
+        sim.setMapGenerator(std::make_unique<FlakyMapGenerator>(1, false));
+        bool threw = false;
+        try { sim.generateMap(); } catch (const MapGenerationError &) { threw = true; }
+        ASSERT(threw);
+    }
+    return true;
+}
+
+bool test_contraction_hierarchy_matches_dstar() {
+    std::mt19937 rng(41);
+    for (int round = 0; round < 6; ++round) {
+        // random walls: open rooms, corridors, rings and cut-off pockets
+        const int rows = 12 + round * 7, cols = 15 + round * 5;
+        std::vector<std::string> grid(rows, std::string(cols, '.'));
+        std::uniform_int_distribution<int> pct(0, 99);
+        const int density = 25 + round * 5;
+        for (auto &row : grid)
+            for (char &c : row)
+                if (pct(rng) < density)
+                    c = '#';
+        ContractionHierarchy ch(grid);
+        ASSERT(ch.junctions() <= ch.cells() && ch.memoryBytes() > 0);
+        std::uniform_int_distribution<int> rx(0, rows - 1), ry(0, cols - 1);
+        for (int q = 0; q < 150; ++q) {
+            Vec2 a{rx(rng), ry(rng)}, b{rx(rng), ry(rng)};
+            if (a.x == b.x && a.y == b.y)
+                continue;
+            DStarLite planner(rows, cols, b);
+            const int expected = grid[b.x][b.y] == '#' ? -1 : planner.distanceFrom(grid, a);
+            ASSERT(ch.distance(a, b) == expected);
+            std::vector<Vec2> path;
+            const bool found = ch.appendPath(a, b, path);
+            if (expected < 0) {
+                ASSERT(!found && path.empty());
+                continue;
+            }
+            ASSERT(found && (int)path.size() == expected);
+            Vec2 cur = a;
+            for (const Vec2 &next : path) {
+                ASSERT(std::abs(next.x - cur.x) + std::abs(next.y - cur.y) == 1);
+                ASSERT(grid[next.x][next.y] != '#');
+                cur = next;
+            }
+            ASSERT(cur.x == b.x && cur.y == b.y);
+        }
+    }
+
+    // wired into the simulation: ground queries go through the hierarchy
+    std::string map = makeTempPath("map_ch");
+    writeFile(map,
+        "B....#....D\n"
+        ".##.##.##..\n"
+        "..S.....#.D\n"
+    );
+    std::string cfg = makeTempPath("cfg_ch");
+    writeFile(cfg,
+        "MAP_SIZE: 3 11\n"
+        "GROUND_ORACLE: CH\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    ASSERT(sim.getGroundOracleForTest() != nullptr);
+    ASSERT(sim.callComputeDistanceForTest({0, 0}, {2, 10}, false) == 16);
+    ASSERT(sim.callFindPathForTest({0, 0}, {2, 10}, false).size() == 16);
+    ASSERT(sim.callComputeDistanceForTest({0, 0}, {0, 5}, false) == -1);
+    ASSERT(sim.setCellBlocked({0, 7}, true)); // the only way east
+    ASSERT(sim.callComputeDistanceForTest({0, 0}, {2, 10}, false) == -1);
+#endif
+    return true;
+}
+
+// RGB of pixel (px, py) in a binary PPM written by FrameExporter
+static bool ppmPixel(const std::string &path, int px, int py, int &w, int &h, uint8_t rgb[3]) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxval = 0;
+    if (!(in >> magic >> w >> h >> maxval) || magic != "P6" || maxval != 255)
+        return false;
+    in.get(); // single whitespace after the header
+    in.seekg((std::streamoff)((long long)px * w + py) * 3, std::ios::cur);
+    return (bool)in.read(reinterpret_cast<char *>(rgb), 3);
+}
+
+bool test_frame_export_ring() {
+    std::string dir = "/tmp/frames_" + std::to_string(getpid());
+    {
+        // a one-slot ring flooded with big frames: every frame is either
+        // written or counted as dropped, and the first one always lands
+        FrameExporter exporter(dir, 60, 80, 8, 1);
+        const int submitted = 200;
+        for (int t = 0; t < submitted; ++t) {
+            uint8_t *cells = exporter.acquire();
+            if (!cells)
+                continue;
+            std::fill(cells, cells + 60 * 80, (uint8_t)FrameExporter::Road);
+            cells[1 * 80 + 2] = FrameExporter::Scooter;
+            exporter.publish(t);
+        }
+        exporter.close();
+        ASSERT(exporter.written() + exporter.dropped() == submitted);
+        ASSERT(exporter.written() >= 1);
+        int w = 0, h = 0;
+        uint8_t rgb[3];
+        // cell (1,2) covers pixels [8,16) x [16,24)
+        ASSERT(ppmPixel(dir + "/frame_000000.ppm", 15, 23, w, h, rgb));
+        ASSERT(w == 640 && h == 480);
+        ASSERT(std::memcmp(rgb, FrameExporter::palette[FrameExporter::Scooter], 3) == 0);
+        ASSERT(ppmPixel(dir + "/frame_000000.ppm", 16, 23, w, h, rgb));
+        ASSERT(std::memcmp(rgb, FrameExporter::palette[FrameExporter::Road], 3) == 0);
+    }
+
+    // the simulation's frames follow the map legend
+    std::string map = makeTempPath("map_frames");
+    writeFile(map,
+        "B...\n"
+        ".#.D\n"
+    );
+    std::string cfg = makeTempPath("cfg_frames");
+    writeFile(cfg,
+        "MAP_SIZE: 2 4\n"
+        "FRAME_DIR: " + dir + "\n"
+        "FRAME_SCALE: 1\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    FrameExporter *frames = sim.openFrameExportForTest();
+    ASSERT(frames != nullptr);
+    sim.callStepForTest();
+    sim.captureFrameForTest();
+    frames->close();
+    ASSERT(frames->written() == 1);
+    int w = 0, h = 0;
+    uint8_t rgb[3];
+    ASSERT(ppmPixel(dir + "/frame_000001.ppm", 1, 3, w, h, rgb) && w == 4 && h == 2);
+    ASSERT(std::memcmp(rgb, FrameExporter::palette[FrameExporter::Client], 3) == 0);
+    ASSERT(ppmPixel(dir + "/frame_000001.ppm", 1, 1, w, h, rgb));
+    ASSERT(std::memcmp(rgb, FrameExporter::palette[FrameExporter::Wall], 3) == 0);
+#endif
+    return true;
+}
+
+// integer after "key": in a flat JSON text, starting at `from`
+static long long jsonNumber(const std::string &text, const std::string &key, size_t from = 0) {
+    size_t at = text.find("\"" + key + "\": ", from);
+    if (at == std::string::npos)
+        return -1;
+    return std::atoll(text.c_str() + at + key.size() + 4);
+}
+
+bool test_json_report_distributions() {
+    std::string map = makeTempPath("map_json");
+    writeFile(map,
+        "B.....D\n"
+        ".#.#.#.\n"
+        "..S...D\n"
+    );
+    std::string cfg = makeTempPath("cfg_json");
+    writeFile(cfg,
+        "MAP_SIZE: 3 7\n"
+        "DRONES: 1\n"
+        "ROBOTS: 2\n"
+        "SCOOTERS: 1\n"
+        "TOTAL_PACKAGES: 40\n"
+        "SPAWN_FREQUENCY: 2\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    sim.seedRngForTest(43);
+    sim.callSpawnCouriersForTest();
+    for (int t = 0; t < 300 && !sim.isAllDelivered(); ++t)
+        sim.callStepForTest();
+    const KpiLedger &ledger = sim.getLedger();
+    ASSERT(ledger.delivered > 20);
+
+    std::string path = makeTempPath("report_json");
+    sim.writeJsonReportForTest(path);
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string json = ss.str();
+    ASSERT(json.front() == '{' && json.find("}\n}") != std::string::npos);
+    ASSERT(jsonNumber(json, "delivered") == ledger.delivered);
+
+    // each distribution saw one sample per event and is ordered
+    const size_t latency = json.find("\"delivery_latency_ticks\"");
+    const size_t wait = json.find("\"pool_wait_ticks\"");
+    ASSERT(latency != std::string::npos && wait != std::string::npos);
+    ASSERT(jsonNumber(json, "count", latency) == ledger.delivered);
+    ASSERT(jsonNumber(json, "count", wait) == ledger.assigned);
+    const long long p50 = jsonNumber(json, "p50", latency), p99 = jsonNumber(json, "p99", latency);
+    ASSERT(p50 >= 0 && p50 <= p99 && p99 <= jsonNumber(json, "max", latency));
+    ASSERT(jsonNumber(json, "count", json.find("\"lateness_ticks\"")) == ledger.deliveredLate);
+
+    // per-type totals match the fleet counters, and every move cost energy
+    long long distance = 0, energy = 0;
+    for (const char *kind : {"drone", "robot", "scooter"}) {
+        const size_t at = json.find(std::string("\"") + kind + "\"");
+        ASSERT(at != std::string::npos);
+        distance += jsonNumber(json, "distance", at);
+        energy += jsonNumber(json, "energy_used", at);
+    }
+    long long ledgerDistance = 0;
+    for (const auto &f : ledger.fleet) {
+        ledgerDistance += f.distance;
+        ASSERT(f.busyTicks <= f.aliveTicks);
+    }
+    ASSERT(distance == ledgerDistance && distance > 0 && energy > 0);
+#endif
+    return true;
+}
+
+bool test_fleet_race_picks_best() {
+    ASSERT(FleetRace::tCritical(1) > 12 && FleetRace::tCritical(10) < 2.3 && FleetRace::tCritical(1000) > 1.9);
+
+    // 16 mixes whose true profit is 10 * index, except one clear winner; the
+    // seed moves every mix alike (common random numbers) plus a little noise
+    std::vector<FleetCandidate> candidates(16);
+    for (int i = 0; i < 16; ++i)
+        candidates[i].drones = i;
+    auto truth = [](int i) { return i == 6 ? 400.0 : 10.0 * i; };
+    std::mt19937 rng(44);
+    std::normal_distribution<double> seedShift(0, 200), noise(0, 15);
+    std::vector<double> shift;
+
+    const int maxSeeds = 16;
+    FleetRace race(candidates, 2, maxSeeds);
+    size_t runs = 0;
+    do {
+        for (auto [c, s] : race.pendingRuns()) {
+            while ((int)shift.size() <= s)
+                shift.push_back(seedShift(rng));
+            race.record(c, s, truth(c) + shift[s] + noise(rng));
+            ++runs;
+        }
+        ASSERT(race.pendingRuns().empty());
+    } while (race.nextRound());
+
+    ASSERT(race.leader() == 6);
+    ASSERT(race.candidates()[6].alive());
+    ASSERT(runs < 16 * maxSeeds / 2);
+    int alive = 0;
+    for (const FleetCandidate &c : race.candidates())
+        alive += c.alive();
+    ASSERT(alive >= 1 && alive <= 3);
+
+    // a crashed replica drops its mix without feeding a fake profit into
+    // anyone's statistics
+    FleetRace crashy(candidates, 2, maxSeeds);
+    do {
+        for (auto [c, s] : crashy.pendingRuns()) {
+            if (c == 9 && s == 1)
+                crashy.recordCrash(c);
+            else
+                crashy.record(c, s, truth(c) + shift[s]);
+        }
+    } while (crashy.nextRound());
+    const FleetCandidate &crashed = crashy.candidates()[9];
+    ASSERT(crashed.crashes == 1 && crashed.eliminatedInRound == 0);
+    ASSERT(crashed.mean() == truth(9) + shift[0]);
+    ASSERT(crashy.leader() == 6);
+    return true;
+}
+
+// (destination, reward, deadline) of every spawned package
+static std::vector<std::array<int, 4>> spawnedPackages(const std::string &cfgPath, bool regenerate,
+                                                       std::vector<std::string> *grid = nullptr) {
+    std::vector<std::array<int, 4>> out;
+    Simulation sim(cfgPath);
+    sim.loadConfig();
+    sim.generateMap();
+#ifdef UNIT_TEST
+    if (regenerate)
+        sim.generateMap(); // an extra generator call no longer shifts the demand
+    if (grid)
+        *grid = sim.getMapForTest().grid;
+    for (int t = 0; t < 30; ++t) {
+        sim.setCurrentTickForTest(t);
+        sim.callSpawnPackageForTest();
+    }
+    for (const auto &p : sim.getPackagesForTest())
+        out.push_back({p->getDestX(), p->getDestY(), p->getReward(), p->getDeadline()});
+#endif
+    return out;
+}
+
+bool test_counter_rng_streams() {
+    // Philox4x32-10 known-answer vectors (Random123)
+    auto kat = CounterRng::philox({0, 0, 0, 0}, {0, 0});
+    ASSERT(kat[0] == 0x6627e8d5u && kat[1] == 0xe169c58du && kat[2] == 0xbc57ac4cu && kat[3] == 0x9b00dbd8u);
+    kat = CounterRng::philox({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u});
+    ASSERT(kat[0] == 0xd16cfe09u && kat[1] == 0x94fdccebu && kat[2] == 0x5001e420u && kat[3] == 0x24126ea1u);
+
+    // discard() lands where drawing one by one does
+    CounterRng seq(5, RngStream::PackageSpawn, 2, 17, 9);
+    std::vector<uint32_t> drawn;
+    for (int i = 0; i < 23; ++i)
+        drawn.push_back(seq());
+    for (uint64_t skip : {0, 3, 4, 13, 22}) {
+        CounterRng jump(5, RngStream::PackageSpawn, 2, 17, 9);
+        jump.discard(skip);
+        ASSERT(jump() == drawn[skip] && jump.position() == skip + 1);
+    }
+    // every key field selects a different stream
+    const uint32_t first = CounterRng(5, RngStream::PackageSpawn, 2, 17, 9)();
+    ASSERT(CounterRng(6, RngStream::PackageSpawn, 2, 17, 9)() != first);
+    ASSERT(CounterRng(5, RngStream::LookaheadSpawn, 2, 17, 9)() != first);
+    ASSERT(CounterRng(5, RngStream::PackageSpawn, 3, 17, 9)() != first);
+    ASSERT(CounterRng(5, RngStream::PackageSpawn, 2, 18, 9)() != first);
+    ASSERT(CounterRng(5, RngStream::PackageSpawn, 2, 17, 8)() != first);
+
+    std::string cfg = makeTempPath("cfg_rng");
+    writeFile(cfg,
+        "MAP_SIZE: 30 40\n"
+        "CLIENTS_COUNT: 12\n"
+        "TOTAL_PACKAGES: 30\n"
+        "SEED: 77\n"
+    );
+    std::vector<std::string> grid, replicaGrid;
+    const auto base = spawnedPackages(cfg, false, &grid);
+    ASSERT(base.size() == 30);
+    ASSERT(spawnedPackages(cfg, true) == base);
+
+    // a replica keeps the map and draws its own demand
+    std::ofstream(cfg, std::ios::app) << "REPLICA: 1\n";
+    const auto replica = spawnedPackages(cfg, false, &replicaGrid);
+    ASSERT(replicaGrid == grid && replica.size() == base.size() && replica != base);
+    return true;
+}
+
+bool test_trace_export() {
+    std::string map = makeTempPath("map_trace");
+    writeFile(map,
+        "B.....D\n"
+        ".#.#.#.\n"
+        "..S...D\n"
+    );
+    std::string trace = makeTempPath("trace_json");
+    std::string cfg = makeTempPath("cfg_trace");
+    writeFile(cfg,
+        "MAP_SIZE: 3 7\n"
+        "DRONES: 1\n"
+        "ROBOTS: 1\n"
+        "TOTAL_PACKAGES: 10\n"
+        "SPAWN_FREQUENCY: 2\n"
+        "TRACE_FILE: " + trace + "\n"
+        "TRACE_BUFFER: 4096\n"
+    );
+    ASSERT(TraceRecorder::active() == nullptr);
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    TraceRecorder *rec = sim.openTraceForTest();
+    ASSERT(rec && TraceRecorder::active() == rec);
+    bool threw = false;
+    try { TraceRecorder second(16); } catch (const std::exception &) { threw = true; }
+    ASSERT(threw);
+
+    sim.seedRngForTest(46);
+    sim.callSpawnCouriersForTest();
+    for (int t = 0; t < 60 && !sim.isAllDelivered(); ++t)
+        sim.callStepForTest();
+    ASSERT(sim.getLedger().delivered > 0);
+    // short-lived threads hand their ring on instead of adding one each
+    for (int i = 0; i < 3; ++i)
+        std::thread([] { TraceSpan span("worker span", "i", 1); }).join();
+
+    rec->requestExport();
+    sim.callAdvanceForTest(); // exports between ticks
+    std::ifstream in(trace);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string json = ss.str();
+    ASSERT(json.rfind("{\"displayTimeUnit\"", 0) == 0 && json.find("\n]}\n") != std::string::npos);
+    auto count = [&json](const std::string &needle) {
+        int n = 0;
+        for (size_t at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1))
+            ++n;
+        return n;
+    };
+    const int ticks = count("\"name\": \"tick\"");
+    ASSERT(ticks >= 2 && count("\"name\": \"movement\"") == ticks);
+    ASSERT(count("\"name\": \"dispatch: costs\"") > 0);
+    ASSERT(count("\"name\": \"deliver\"") == sim.getLedger().delivered);
+    ASSERT(count("\"name\": \"assign\"") == sim.getLedger().assigned);
+    ASSERT(count("\"name\": \"worker span\"") == 3);
+    ASSERT(count("\"thread_name\"") == 2 && count("\"simulation\"") == 1);
+    ASSERT(rec->retained() <= 2 * 4096 && rec->recorded() >= rec->retained());
+#endif
+    return true;
+}
+
+bool test_trace_lookahead_forks_untraced() {
+    std::string map = makeTempPath("map_trace_la");
+    writeFile(map,
+        "B.....D\n"
+        ".#.#.#.\n"
+        "..S...D\n"
+    );
+    std::string trace = makeTempPath("trace_la_json");
+    std::string cfg = makeTempPath("cfg_trace_la");
+    writeFile(cfg,
+        "MAP_SIZE: 3 7\n"
+        "DRONES: 2\n"
+        "ROBOTS: 1\n"
+        "TOTAL_PACKAGES: 10\n"
+        "SPAWN_FREQUENCY: 1\n"
+        "LOOKAHEAD_HORIZON: 4\n"
+        "LOOKAHEAD_CANDIDATES: 3\n"
+        "LOOKAHEAD_BUDGET_US: 1000000\n"
+        "LOOKAHEAD_THREADS: 2\n"
+        "TRACE_FILE: " + trace + "\n"
+        "TRACE_BUFFER: 65536\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.loadMapFromFile(map);
+#ifdef UNIT_TEST
+    TraceRecorder *rec = sim.openTraceForTest();
+    ASSERT(rec);
+    sim.seedRngForTest(46);
+    sim.callSpawnCouriersForTest();
+    for (int t = 0; t < 60 && !sim.isAllDelivered(); ++t)
+        sim.callStepForTest();
+    ASSERT(sim.getLedger().assigned > 0 && sim.getLedger().delivered > 0);
+
+    rec->requestExport();
+    sim.callAdvanceForTest();
+    std::ifstream in(trace);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string json = ss.str();
+    auto count = [&json](const std::string &needle) {
+        int n = 0;
+        for (size_t at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1))
+            ++n;
+        return n;
+    };
+    // the probe and rollout forks assign and deliver too, but only what the
+    // real run commits may reach the trace
+    ASSERT(count("\"name\": \"rollout\"") > 0);
+    ASSERT(count("\"name\": \"assign\"") == sim.getLedger().assigned);
+    ASSERT(count("\"name\": \"deliver\"") == sim.getLedger().delivered);
+#endif
+    return true;
+}
+
+bool test_alloc_accounting() {
+    AllocCounts mark = AllocTracker::thisThread();
+    ::operator delete(::operator new(4000)); // a new-expression could be elided
+    const AllocCounts d = AllocTracker::lap(mark);
+    if (AllocTracker::compiledIn) {
+        ASSERT(d.allocations == 1 && d.frees == 1 && d.bytes == 4000);
+        AllocTracker::credit({3, 1, 64});
+        ASSERT(AllocTracker::lap(mark).allocations == 3);
+    } else {
+        ASSERT(d.allocations == 0 && d.bytes == 0);
+    }
+    ASSERT(AllocTracker::peakRssKb() > 0);
+
+    std::string cfg = makeTempPath("cfg_alloc");
+    std::string report = makeTempPath("report_alloc");
+    writeFile(cfg,
+        "MAP_SIZE: 20 20\n"
+        "MAX_TICKS: 50\n"
+        "TOTAL_PACKAGES: 20\n"
+        "SEED: 47\n"
+        "REPORT_JSON: " + report + "\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.generateMap();
+#ifdef UNIT_TEST
+    sim.callSpawnCouriersForTest();
+    for (int t = 0; t < 50; ++t)
+        sim.callAdvanceForTest();
+    const PhaseAllocs &phases = sim.getPhaseAllocs();
+    ASSERT(AllocTracker::compiledIn == (phases.dispatch.allocations > 0));
+    sim.writeJsonReportForTest(report);
+    std::ifstream in(report);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    ASSERT(jsonNumber(ss.str(), "peak_rss_kb") > 0);
+    ASSERT(AllocTracker::compiledIn == (ss.str().find("\"allocations_per_tick\"") != std::string::npos));
+#endif
+    return true;
+}
+
+bool test_tick_arena_reuse() {
+    TickArena arena;
+    for (int tick = 0; tick < 3; ++tick) {
+        arena.reset();
+        double *d = arena.allocate<double>(1000);
+        ASSERT(((uintptr_t)d % alignof(double)) == 0);
+        for (int i = 0; i < 1000; ++i)
+            d[i] = i;
+        ArenaVector<int> v{ArenaAllocator<int>(arena)};
+        for (int i = 0; i < 500; ++i)
+            v.push_back(i);
+        ASSERT(v[499] == 499 && d[999] == 999);
+    }
+    // the first tick spilled; later ticks fit in the folded block
+    const size_t cap = arena.capacity();
+    ASSERT(cap >= arena.highWater() && arena.highWater() >= 8000);
+    AllocCounts mark = AllocTracker::thisThread();
+    arena.reset();
+    arena.allocate<double>(1000);
+    ASSERT(AllocTracker::lap(mark).allocations == 0);
+    ASSERT(arena.capacity() == cap);
+
+    SearchWorkspace ws;
+    for (int search = 0; search < 3; ++search) {
+        ws.begin(16);
+        ASSERT(!ws.visited(5)); // marks from the last search are stale
+        ws.push(5, -1);
+        ws.push(6, 5);
+        ASSERT(ws.visited(5) && ws.visited(6) && !ws.visited(7));
+        ASSERT(ws.pop() == 5 && ws.pop() == 6 && ws.empty());
+        ASSERT(ws.parent(6) == 5);
+    }
+    return true;
+}
+
+bool test_shared_state_seqlock() {
+    const std::string name = "/hive_test_" + std::to_string(getpid());
+    {
+        // every field of a frame carries the same value, so a torn copy shows
+        StatePublisher pub(name, 4);
+        StateReader reader(name);
+        SharedFrame f{};
+        std::vector<SharedCourier> cs;
+        ASSERT(!reader.read(f, cs)); // nothing published yet
+        std::atomic<bool> done{false};
+        std::atomic<int> consistent{0};
+        int last = 0;
+        std::thread writer([&] {
+            // keep overwriting until the reader has had plenty of chances to tear
+            for (int v = 1; v <= 20000 || consistent < 2000; ++v) {
+                last = v;
+                pub.frame.tick = pub.frame.waiting = pub.frame.delivered = v;
+                pub.frame.profit = v;
+                pub.couriers.assign(1 + v % 4, SharedCourier{v, v, v, v, 0, 0, 0, 0});
+                pub.publish();
+            }
+            done = true;
+        });
+        bool torn = false;
+        while (!done) {
+            if (!reader.read(f, cs))
+                continue;
+            ++consistent;
+            torn |= f.waiting != f.tick || f.delivered != f.tick || f.profit != f.tick ||
+                    (int)cs.size() != 1 + f.tick % 4;
+            for (const auto &c : cs)
+                torn |= c.x != f.tick || c.battery != f.tick;
+        }
+        writer.join();
+        ASSERT(!torn);
+        ASSERT(reader.read(f, cs) && f.tick == last);
+        ASSERT(reader.live() && pub.published() == last);
+    }
+    // the publisher unlinked the segment
+    bool reopened = true;
+    try { StateReader gone(name); } catch (const FileOpenError &) { reopened = false; }
+    ASSERT(!reopened);
+
+    // a run publishes its couriers and KPIs
+    std::string cfg = makeTempPath("cfg_shm");
+    writeFile(cfg,
+        "MAP_SIZE: 20 20\n"
+        "TOTAL_PACKAGES: 20\n"
+        "SEED: 49\n"
+        "SHARED_STATE: " + name + "\n"
+    );
+    Simulation sim(cfg);
+    sim.loadConfig();
+    sim.generateMap();
+#ifdef UNIT_TEST
+    sim.callSpawnCouriersForTest();
+    ASSERT(sim.openSharedStateForTest() != nullptr);
+    for (int t = 0; t < 30; ++t)
+        sim.callAdvanceForTest();
+    sim.publishStateForTest();
+    StateReader reader(name);
+    SharedFrame f{};
+    std::vector<SharedCourier> cs;
+    ASSERT(reader.read(f, cs));
+    ASSERT(f.tick == 30 && f.rows == 20 && f.spawned == sim.getLedger().spawned);
+    ASSERT(cs.size() == sim.getCouriersForTest().size() && !cs.empty());
+    ASSERT(cs[0].x == sim.getCouriersForTest()[0]->getPos().x);
+    ASSERT(cs[0].battery == sim.getCouriersForTest()[0]->getBattery());
+#endif
+    return true;
+}
+
+// scalar statement of the dispatch score, as pairs were costed one at a time
+static long long referencePairCost(int dist, int outBound, int after, int here, int speed, int consumption,
+                                   int tickCost, int budget, int capacity, int rate, int reward, int deadline,
+                                   int tick) {
+    const long long INF = 1000000000000LL;
+    auto ticks = [&](int d) { return (d + speed - 1) / speed; };
+    auto need = [&](int d) { return ticks(d) * consumption; };
+    if (capacity < need(outBound) + need(after) || dist < 0)
+        return INF;
+    int eta = ticks(dist);
+    if (budget < need(dist) + need(after)) {
+        if (here < 0 || budget < need(here) || capacity < need(here + dist) + need(after))
+            return INF;
+        const int deficit = need(here + dist) + need(after) - (budget - need(here));
+        eta = ticks(here) + (deficit + rate - 1) / rate + ticks(here + dist);
+    }
+    const int lateness = std::max(0, tick + eta - deadline);
+    const int score = reward - eta * tickCost - lateness * 50;
+    return score <= -1000000 ? INF : -(long long)score;
+}
+
+bool test_score_batch_matches_scalar() {
+    std::mt19937 rng(50);
+    auto pick = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+    const int n = 257; // not a multiple of any vector width
+    std::vector<int32_t> speed(n), consumption(n), tickCost(n), budget(n), capacity(n), rate(n), here(n);
+    std::vector<int32_t> dist(n), outBound(n), after(n);
+    std::vector<long long> out(n);
+    ScoreBatch b;
+    b.count = n;
+    b.speed = speed.data();
+    b.consumption = consumption.data();
+    b.cost = tickCost.data();
+    b.budget = budget.data();
+    b.capacity = capacity.data();
+    b.chargeRate = rate.data();
+    b.here = here.data();
+    b.dist = dist.data();
+    b.outBound = outBound.data();
+    b.after = after.data();
+    int direct = 0, detour = 0, infeasible = 0;
+    for (int round = 0; round < 200; ++round) {
+        for (int j = 0; j < n; ++j) {
+            speed[j] = pick(1, 4);
+            consumption[j] = pick(0, 3);
+            tickCost[j] = pick(1, 8);
+            const int maxBattery = pick(50, 300);
+            capacity[j] = maxBattery - maxBattery * pick(0, 3) * 10 / 100;
+            budget[j] = pick(-20, capacity[j]);
+            rate[j] = std::max(1, maxBattery / 4);
+            here[j] = pick(-1, 30);
+            outBound[j] = pick(0, 120);
+            dist[j] = pick(0, 9) == 0 ? -1 : outBound[j] + pick(0, 60);
+            after[j] = pick(0, 40);
+        }
+        // includes huge distances, where the float route must stay exact
+        dist[0] = 20000001;
+        outBound[0] = 1000;
+        consumption[0] = 0;
+        const int reward = pick(50, 500), deadline = pick(0, 400), tick = pick(0, 300);
+        scoreBatch(b, reward, deadline, tick, 1000000000000LL, out.data());
+        for (int j = 0; j < n; ++j) {
+            const long long want = referencePairCost(dist[j], outBound[j], after[j], here[j], speed[j],
+                                                     consumption[j], tickCost[j], budget[j], capacity[j],
+                                                     rate[j], reward, deadline, tick);
+            ASSERT(out[j] == want);
+            if (want == 1000000000000LL)
+                ++infeasible;
+            else if (budget[j] >= (dist[j] + speed[j] - 1) / speed[j] * consumption[j] +
+                                       (after[j] + speed[j] - 1) / speed[j] * consumption[j])
+                ++direct;
+            else
+                ++detour;
+        }
+    }
+    // every branch of the scalar form was exercised
+    ASSERT(direct > 0 && detour > 0 && infeasible > 0);
+    return true;
+}
+
 int main() {
     struct Test { const char *name; bool (*fn)(); };
     Test tests[] = {
@@ -206,6 +2010,33 @@ int main() {
         {"spawnPackage_deadline_relative", test_spawnPackage_deadline_relative},
         {"hungarian_assigns_package_basic", test_hungarian_assigns_package_basic},
         {"singleton_enforcement", test_singleton_enforcement},
+        {"snapshot_roundtrip_and_fork", test_snapshot_roundtrip_and_fork},
+        {"lookahead_dispatch", test_lookahead_dispatch},
+        {"dynamic_obstacles_incremental_repair", test_dynamic_obstacles_incremental_repair},
+        {"noise_generator_deterministic_and_connected", test_noise_generator_deterministic_and_connected},
+        {"procedural_map_connected_by_construction", test_procedural_map_connected_by_construction},
+        {"telemetry_csv_and_binary", test_telemetry_csv_and_binary},
+        {"kpi_ledger_matches_recount", test_kpi_ledger_matches_recount},
+        {"dispatch_rule_table", test_dispatch_rule_table},
+        {"charger_field_and_station_stop", test_charger_field_and_station_stop},
+        {"event_engine_matches_tick_engine", test_event_engine_matches_tick_engine},
+        {"order_queue_mpsc", test_order_queue_mpsc},
+        {"dispatch_service_socket", test_dispatch_service_socket},
+        {"cooperative_reservations", test_cooperative_reservations},
+        {"cooperative_closed_via_replans", test_cooperative_closed_via_replans},
+        {"anytime_dispatch_budget", test_anytime_dispatch_budget},
+        {"map_regeneration_follows_generator", test_map_regeneration_follows_generator},
+        {"contraction_hierarchy_matches_dstar", test_contraction_hierarchy_matches_dstar},
+        {"frame_export_ring", test_frame_export_ring},
+        {"json_report_distributions", test_json_report_distributions},
+        {"fleet_race_picks_best", test_fleet_race_picks_best},
+        {"counter_rng_streams", test_counter_rng_streams},
+        {"trace_export", test_trace_export},
+        {"trace_lookahead_forks_untraced", test_trace_lookahead_forks_untraced},
+        {"alloc_accounting", test_alloc_accounting},
+        {"tick_arena_reuse", test_tick_arena_reuse},
+        {"shared_state_seqlock", test_shared_state_seqlock},
+        {"score_batch_matches_scalar", test_score_batch_matches_scalar},
     };
 
     int failed = 0;